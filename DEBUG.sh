@@ -7,7 +7,7 @@ fi
 echo `pwd`\/bin\/$NAME
 echo
 
-g++ vector.cpp matrix.cpp main.cpp -D DEBUG -O3 -o ./bin/$NAME &&
+g++ vector.cpp matrix.cpp structured.cpp batch.cpp reduce.cpp solver.cpp chain.cpp external.cpp capi.cpp quantized.cpp incremental.cpp gram.cpp stencil.cpp parallel.cpp profile.cpp main.cpp -pthread -D DEBUG -O3 -march=native -fno-math-errno -o ./bin/$NAME &&
 ./bin/$NAME
 
 
@@ -5,7 +5,7 @@ if ! [ -d ./bin ]; then
     mkdir bin;
 fi
 
-g++ vector.cpp matrix.cpp main.cpp -o ./bin/$NAME &&
+g++ vector.cpp matrix.cpp structured.cpp batch.cpp reduce.cpp solver.cpp chain.cpp external.cpp capi.cpp quantized.cpp incremental.cpp gram.cpp stencil.cpp parallel.cpp profile.cpp main.cpp -pthread -O3 -march=native -fno-math-errno -o ./bin/$NAME &&
 ./bin/$NAME
 
 
@@ -0,0 +1,265 @@
+#ifndef BATCH_CPP
+#define BATCH_CPP
+
+
+#include "batch.hpp"
+#include "parallel.hpp"
+#include <stdexcept>
+#include <iomanip>
+#include <cmath>
+
+
+namespace linear {
+    // примерная стоимость одной пары в элементах, для решения о запуске потоков
+    static const long unsigned int pair_cost = 16;
+
+    /// Batch of size uninitialized 3-D vectors
+    batch::batch (long unsigned int size)
+    : m_size (size), m_stride ((size + 7) / 8 * 8) {
+        if (size < 1)
+            throw std::invalid_argument ("Invalid batch size ");
+        m_data = new double[3 * m_stride];
+    }
+
+    /// Batch of size copies of def
+    batch::batch (long unsigned int size, const vector& def)
+    : batch (size) {
+        if (def.get_width() * def.get_height() != 3)
+            throw std::invalid_argument ("Invalid vectors ");
+        double dx = def.m_data[0], dy = def.m_data[1], dz = def.m_data[2];
+        double* X = x();
+        double* Y = y();
+        double* Z = z();
+        parallel::for_range (m_size, 3UL, [=] (long unsigned int begin, long unsigned int end) {
+            for (long unsigned int i = begin; i < end; i++) {
+                X[i] = dx;
+                Y[i] = dy;
+                Z[i] = dz;
+            }
+        });
+    }
+
+    batch::batch (const batch& refer)
+    : batch (refer.m_size) {
+        for (long unsigned int i = 0; i < 3 * m_stride; i++)
+            m_data[i] = refer.m_data[i];
+    }
+
+    batch::batch (batch&& refer)
+    : m_data (refer.m_data), m_size (refer.m_size), m_stride (refer.m_stride) {
+        refer.m_data = nullptr;
+        refer.m_size = 0;
+        refer.m_stride = 0;
+    }
+
+    batch::batch (const std::initializer_list<vector> &list)
+    : batch (list.size()) {
+        long unsigned int count = 0;
+        for (auto &element : list)
+            set (count++, element);
+    }
+
+    batch::~batch() {
+        delete[] m_data;
+    }
+
+
+    double* batch::x() const {
+        return m_data;
+    }
+
+    double* batch::y() const {
+        return m_data + m_stride;
+    }
+
+    double* batch::z() const {
+        return m_data + 2 * m_stride;
+    }
+
+
+    // вспомогательные
+    long unsigned int batch::get_size() const {
+        return m_size;
+    }
+
+    static void abs_kernel (const double* __restrict X, const double* __restrict Y, const double* __restrict Z,
+                            double* __restrict out, long unsigned int begin, long unsigned int end) {
+        for (long unsigned int i = begin; i < end; i++)
+            out[i] = std::sqrt (X[i] * X[i] + Y[i] * Y[i] + Z[i] * Z[i]);
+    }
+
+    vector batch::abs() const {
+        vector result (m_size);
+        double* out = result.m_data;
+        parallel::for_range (m_size, pair_cost, [this, out] (long unsigned int begin, long unsigned int end) {
+            abs_kernel (x(), y(), z(), out, begin, end);
+        });
+        return result;
+    }
+
+    vector batch::get (long unsigned int index) const {
+        if (index >= m_size)
+            throw std::out_of_range ("Index is out of range ");
+        return vector {x()[index], y()[index], z()[index]};
+    }
+
+    void batch::set (long unsigned int index, const vector& V) {
+        if (index >= m_size)
+            throw std::out_of_range ("Index is out of range ");
+        if (V.get_width() * V.get_height() != 3)
+            throw std::invalid_argument ("Invalid vectors ");
+        x()[index] = V.m_data[0];
+        y()[index] = V.m_data[1];
+        z()[index] = V.m_data[2];
+    }
+
+
+    // присваивание
+    batch& batch::operator= (const batch& refer) {
+        if (&refer == this)
+            return *this;
+        if (m_stride != refer.m_stride) {
+            delete[] m_data;
+            m_stride = refer.m_stride;
+            m_data = new double[3 * m_stride];
+        }
+        m_size = refer.m_size;
+        for (long unsigned int i = 0; i < 3 * m_stride; i++)
+            m_data[i] = refer.m_data[i];
+        return *this;
+    }
+
+    batch& batch::operator= (batch&& refer) {
+        if (&refer == this)
+            return *this;
+        delete[] m_data;
+        m_data = refer.m_data;
+        m_size = refer.m_size;
+        m_stride = refer.m_stride;
+        refer.m_data = nullptr;
+        refer.m_size = 0;
+        refer.m_stride = 0;
+        return *this;
+    }
+
+
+    // ядра над отрезком [begin, end) пар; __restrict позволяет векторизацию
+    static void scal_kernel (const double* __restrict ax, const double* __restrict ay, const double* __restrict az,
+                             const double* __restrict bx, const double* __restrict by, const double* __restrict bz,
+                             double* __restrict out, long unsigned int begin, long unsigned int end) {
+        for (long unsigned int i = begin; i < end; i++)
+            out[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+    }
+
+    /* cos = (a, b) / sqrt (|a|^2 |b|^2): один корень на пару */
+    static void cos_kernel (const double* __restrict ax, const double* __restrict ay, const double* __restrict az,
+                            const double* __restrict bx, const double* __restrict by, const double* __restrict bz,
+                            double* __restrict out, long unsigned int begin, long unsigned int end) {
+        for (long unsigned int i = begin; i < end; i++) {
+            double dot = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+            double aa = ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i];
+            double bb = bx[i] * bx[i] + by[i] * by[i] + bz[i] * bz[i];
+            out[i] = dot / std::sqrt (aa * bb);
+        }
+    }
+
+    /* sin = sqrt (|a x b|^2 / (|a|^2 |b|^2)), векторное произведение не хранится */
+    static void sin_kernel (const double* __restrict ax, const double* __restrict ay, const double* __restrict az,
+                            const double* __restrict bx, const double* __restrict by, const double* __restrict bz,
+                            double* __restrict out, long unsigned int begin, long unsigned int end) {
+        for (long unsigned int i = begin; i < end; i++) {
+            double cx = ay[i] * bz[i] - az[i] * by[i];
+            double cy = az[i] * bx[i] - ax[i] * bz[i];
+            double cz = ax[i] * by[i] - ay[i] * bx[i];
+            double aa = ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i];
+            double bb = bx[i] * bx[i] + by[i] * by[i] + bz[i] * bz[i];
+            out[i] = std::sqrt ((cx * cx + cy * cy + cz * cz) / (aa * bb));
+        }
+    }
+
+    /* угол в градусах: векторный проход по блоку, затем atan2 по нему же */
+    static void angle_kernel (const double* __restrict ax, const double* __restrict ay, const double* __restrict az,
+                              const double* __restrict bx, const double* __restrict by, const double* __restrict bz,
+                              double* __restrict out, long unsigned int begin, long unsigned int end) {
+        const long unsigned int block = 256;
+        double cross[block];
+        for (long unsigned int first = begin; first < end; first += block) {
+            long unsigned int count = (end - first < block)? end - first: block;
+            for (long unsigned int k = 0; k < count; k++) {
+                long unsigned int i = first + k;
+                double cx = ay[i] * bz[i] - az[i] * by[i];
+                double cy = az[i] * bx[i] - ax[i] * bz[i];
+                double cz = ax[i] * by[i] - ay[i] * bx[i];
+                cross[k] = std::sqrt (cx * cx + cy * cy + cz * cz);
+                out[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+            }
+            for (long unsigned int k = 0; k < count; k++)
+                out[first + k] = std::atan2 (cross[k], out[first + k]) * 180 / M_PI;
+        }
+    }
+
+    vector batch::pairwise (const batch& A, const batch& B, pair_kernel kernel) {
+        if (A.m_size != B.m_size)
+            throw std::invalid_argument ("Invalid vectors ");
+        vector result (A.m_size);
+        double* out = result.m_data;
+        parallel::for_range (A.m_size, pair_cost, [&A, &B, kernel, out] (long unsigned int begin, long unsigned int end) {
+            kernel (A.x(), A.y(), A.z(), B.x(), B.y(), B.z(), out, begin, end);
+        });
+        return result;
+    }
+
+
+    // внешние функции
+    batch vect_mul (const batch& A, const batch& B) {
+        batch C (A.m_size);
+        vect_mul (A, B, C);
+        return C;
+    }
+
+    static void cross_kernel (const double* __restrict ax, const double* __restrict ay, const double* __restrict az,
+                              const double* __restrict bx, const double* __restrict by, const double* __restrict bz,
+                              double* __restrict cx, double* __restrict cy, double* __restrict cz,
+                              long unsigned int begin, long unsigned int end) {
+        for (long unsigned int i = begin; i < end; i++) {
+            cx[i] = ay[i] * bz[i] - az[i] * by[i];
+            cy[i] = az[i] * bx[i] - ax[i] * bz[i];
+            cz[i] = ax[i] * by[i] - ay[i] * bx[i];
+        }
+    }
+
+    void vect_mul (const batch& A, const batch& B, batch& C) {
+        if (A.m_size != B.m_size || A.m_size != C.m_size)
+            throw std::invalid_argument ("Invalid vectors ");
+        parallel::for_range (A.m_size, pair_cost, [&A, &B, &C] (long unsigned int begin, long unsigned int end) {
+            cross_kernel (A.x(), A.y(), A.z(), B.x(), B.y(), B.z(), C.x(), C.y(), C.z(), begin, end);
+        });
+    }
+
+    vector scal_mul (const batch& A, const batch& B) {
+        return batch::pairwise (A, B, scal_kernel);
+    }
+
+    vector cos (const batch& A, const batch& B) {
+        return batch::pairwise (A, B, cos_kernel);
+    }
+
+    vector sin (const batch& A, const batch& B) {
+        return batch::pairwise (A, B, sin_kernel);
+    }
+
+    vector angle (const batch& A, const batch& B) {
+        return batch::pairwise (A, B, angle_kernel);
+    }
+
+
+    // стейтмент вывода
+    std::ostream& operator<< (std::ostream& out, const batch& V) {
+        for (long unsigned int i = 0; i < V.m_size; i++)
+            out << V.get (i) << ((i == V.m_size - 1)? "": "\n");
+        return out;
+    }
+}
+
+
+#endif /* BATCH_CPP */
@@ -0,0 +1,67 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+
+#include "vector.hpp"
+#include <iostream>
+#include <initializer_list>
+
+
+namespace linear {
+    // N трёхмерных векторов в раскладке SoA: все x, затем все y, затем все z
+    class batch {
+        // внешние функции
+        friend batch vect_mul (const batch&, const batch&);
+        friend void vect_mul (const batch&, const batch&, batch&);
+        friend vector scal_mul (const batch&, const batch&);
+        friend vector cos (const batch&, const batch&);
+        friend vector sin (const batch&, const batch&);
+        friend vector angle (const batch&, const batch&);
+
+        // стейтмент вывода
+        friend std::ostream& operator<< (std::ostream&, const batch&);
+
+        private:
+            double* m_data;
+            long unsigned int m_size;
+            long unsigned int m_stride; // расстояние между компонентами, кратно 8
+
+            double* x() const;
+            double* y() const;
+            double* z() const;
+
+            // попарное ядро над пакетами, результат - вектор длины size
+            typedef void (*pair_kernel) (const double* __restrict, const double* __restrict, const double* __restrict,
+                                         const double* __restrict, const double* __restrict, const double* __restrict,
+                                         double* __restrict, long unsigned int, long unsigned int);
+            static vector pairwise (const batch&, const batch&, pair_kernel);
+
+        public:
+            explicit batch (long unsigned int size = 1);
+            explicit batch (long unsigned int size, const vector& def);
+            batch (const batch&);
+            batch (batch&&);
+            batch (const std::initializer_list<vector> &list);
+            ~batch();
+
+            // вспомогательные
+            long unsigned int get_size() const;
+            vector abs() const;
+            vector get (long unsigned int index) const;
+            void set (long unsigned int index, const vector&);
+
+            // присваивание
+            batch& operator= (const batch&);
+            batch& operator= (batch&&);
+    };
+
+    batch vect_mul (const batch&, const batch&); // попарные векторные произведения
+    void vect_mul (const batch&, const batch&, batch& result); // без выделения памяти
+    vector scal_mul (const batch&, const batch&); // попарные скалярные произведения
+    vector cos (const batch&, const batch&);
+    vector sin (const batch&, const batch&);
+    vector angle (const batch&, const batch&);
+}
+
+
+#endif /* BATCH_HPP */
@@ -0,0 +1,139 @@
+#ifndef CAPI_CPP
+#define CAPI_CPP
+
+
+#include "linear.h"
+#include "external.hpp"
+#include <stdexcept>
+#include <string>
+#include <new>
+
+
+struct linear_matrix {
+    linear::matrix value;
+};
+
+
+namespace linear {
+    static thread_local std::string last_error;
+
+    /* исключения не пересекают границу C */
+    template <class Body>
+    static linear_status guarded (Body body) {
+        try {
+            body();
+            last_error.clear();
+            return LINEAR_OK;
+        } catch (const singular_error& error) {
+            last_error = error.what();
+            return LINEAR_SINGULAR;
+        } catch (const std::length_error& error) {
+            last_error = error.what();
+            return LINEAR_SIZE;
+        } catch (const std::out_of_range& error) {
+            last_error = error.what();
+            return LINEAR_SIZE;
+        } catch (const std::invalid_argument& error) {
+            last_error = error.what();
+            return LINEAR_INVALID;
+        } catch (const std::bad_alloc& error) {
+            last_error = error.what();
+            return LINEAR_MEMORY;
+        } catch (const std::exception& error) {
+            last_error = error.what();
+            return LINEAR_FAILURE;
+        } catch (...) {
+            last_error = "Unknown error ";
+            return LINEAR_FAILURE;
+        }
+    }
+
+    static matrix_view handle_view (const linear_matrix* M) {
+        if (M == nullptr)
+            throw std::invalid_argument ("Invalid matrix ");
+        linear_matrix* handle = const_cast<linear_matrix*> (M);
+        return view (handle->value);
+    }
+}
+
+
+extern "C" {
+    linear_matrix* linear_create (size_t width, size_t height) {
+        linear_matrix* result = nullptr;
+        linear::guarded ([&] {
+            result = new linear_matrix {linear::matrix (width, height)};
+        });
+        return result;
+    }
+
+    linear_matrix* linear_wrap (double* data, size_t width, size_t height,
+                                linear_deleter release, void* context) {
+        linear_matrix* result = nullptr;
+        linear::guarded ([&] {
+            if (release == nullptr)
+                result = new linear_matrix {linear::matrix (data, width, height)};
+            else
+                result = new linear_matrix {linear::matrix (data, width, height, [release, context] (double* buffer) {
+                    release (buffer, context);
+                })};
+        });
+        return result;
+    }
+
+    void linear_destroy (linear_matrix* M) {
+        delete M;
+    }
+
+    double* linear_data (linear_matrix* M) {
+        if (M == nullptr)
+            return nullptr;
+        return linear::view (M->value).get_data();
+    }
+
+    size_t linear_width (const linear_matrix* M) {
+        return (M == nullptr)? 0: M->value.get_width();
+    }
+
+    size_t linear_height (const linear_matrix* M) {
+        return (M == nullptr)? 0: M->value.get_height();
+    }
+
+    linear_status linear_multiply (const linear_matrix* A, const linear_matrix* B, linear_matrix* C) {
+        return linear::guarded ([&] {
+            linear::gemm (linear::handle_view (A), linear::handle_view (B), linear::handle_view (C));
+        });
+    }
+
+    linear_status linear_gemm (size_t rows, size_t inner, size_t cols,
+                               const double* a, size_t lda, const double* b, size_t ldb,
+                               double* c, size_t ldc) {
+        return linear::guarded ([&] {
+            linear::gemm (linear::view (const_cast<double*> (a), inner, rows, lda),
+                          linear::view (const_cast<double*> (b), cols, inner, ldb),
+                          linear::view (c, cols, rows, ldc));
+        });
+    }
+
+    linear_status linear_add (size_t rows, size_t cols,
+                              const double* a, size_t lda, const double* b, size_t ldb,
+                              double* c, size_t ldc) {
+        return linear::guarded ([&] {
+            linear::add (linear::view (const_cast<double*> (a), cols, rows, lda),
+                         linear::view (const_cast<double*> (b), cols, rows, ldb),
+                         linear::view (c, cols, rows, ldc));
+        });
+    }
+
+    linear_status linear_solve (size_t n, size_t cols, double* a, size_t lda, double* b, size_t ldb) {
+        return linear::guarded ([&] {
+            linear::solve (linear::view (a, n, n, lda), linear::view (b, cols, n, ldb));
+        });
+    }
+
+    const char* linear_error (void) {
+        return linear::last_error.c_str();
+    }
+}
+
+
+#endif /* CAPI_CPP */
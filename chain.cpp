@@ -0,0 +1,250 @@
+#ifndef CHAIN_CPP
+#define CHAIN_CPP
+
+
+#include "chain.hpp"
+#include "parallel.hpp"
+#include <stdexcept>
+#include <functional>
+#include <limits>
+#include <utility>
+
+
+namespace linear {
+    // сомножитель
+    operand::operand (const matrix& M, bool transposed)
+    : m_matrix (M), m_transposed (transposed) {}
+
+    long unsigned int operand::get_height() const {
+        return m_transposed? m_matrix.get_width(): m_matrix.get_height();
+    }
+
+    long unsigned int operand::get_width() const {
+        return m_transposed? m_matrix.get_height(): m_matrix.get_width();
+    }
+
+    operand transposed (const matrix& M) {
+        return operand (M, true);
+    }
+
+
+    /* окно в данных: элемент (i, j) = data[i * row + j * col] */
+    struct _view {
+        const double* data;
+        long unsigned int row;
+        long unsigned int col;
+    };
+
+    /* C = X * Y, X - rows x inner, Y - inner x cols, C плотная по строкам */
+    static void gemm (_view X, _view Y, double* C, long unsigned int rows, long unsigned int inner, long unsigned int cols) {
+        parallel::for_range (rows, inner * cols, [X, Y, C, inner, cols] (long unsigned int begin, long unsigned int end) {
+            if (Y.col == 1 && cols > 1) {
+                // строки Y подряд: i-k-j
+                for (long unsigned int i = begin; i < end; i++) {
+                    double* c = C + i * cols;
+                    for (long unsigned int j = 0; j < cols; j++)
+                        c[j] = 0.;
+                    for (long unsigned int k = 0; k < inner; k++) {
+                        double a = X.data[i * X.row + k * X.col];
+                        const double* y = Y.data + k * Y.row;
+                        for (long unsigned int j = 0; j < cols; j++)
+                            c[j] += a * y[j];
+                    }
+                }
+                return;
+            }
+            // столбцы Y подряд (транспонирование или вектор-столбец): скалярные произведения
+            for (long unsigned int i = begin; i < end; i++)
+                for (long unsigned int j = 0; j < cols; j++) {
+                    double sum = 0.;
+                    for (long unsigned int k = 0; k < inner; k++)
+                        sum += X.data[i * X.row + k * X.col] * Y.data[k * Y.row + j * Y.col];
+                    C[i * cols + j] = sum;
+                }
+        });
+    }
+
+    /* буферы промежуточных произведений, переиспользуются по ходу плана */
+    class _workspace {
+        private:
+            std::vector<std::vector<double>> m_free;
+
+        public:
+            std::vector<double> acquire (long unsigned int size) {
+                long unsigned int best = m_free.size();
+                for (long unsigned int k = 0; k < m_free.size(); k++)
+                    if (m_free[k].size() >= size && (best == m_free.size() || m_free[k].size() < m_free[best].size()))
+                        best = k;
+                if (best == m_free.size())
+                    return std::vector<double> (size);
+                std::vector<double> buffer = std::move (m_free[best]);
+                m_free.erase (m_free.begin() + best);
+                return buffer;
+            }
+
+            void release (std::vector<double>&& buffer) {
+                m_free.push_back (std::move (buffer));
+            }
+    };
+
+
+    // цепочка
+    chain::chain (const std::initializer_list<operand> &list)
+    : m_operands (list) {
+        plan();
+    }
+
+    chain::chain (const std::vector<operand>& list)
+    : m_operands (list) {
+        plan();
+    }
+
+    /* ориентация векторов и динамика по формам */
+    void chain::plan() {
+        long unsigned int n = m_operands.size();
+        if (n < 1)
+            throw std::invalid_argument ("Empty chain ");
+
+        // вектор поворачивается к левому соседу, первый - к правому, если тот не вектор
+        auto is_vector = [this] (long unsigned int k) {
+            const matrix& M = m_operands[k].m_matrix;
+            return (M.get_width() == 1) != (M.get_height() == 1);
+        };
+        for (long unsigned int k = 0; k < n; k++) {
+            if (!is_vector (k))
+                continue;
+            operand& current = m_operands[k];
+            if (k > 0) {
+                if (m_operands[k - 1].get_width() != current.get_height()
+                    && m_operands[k - 1].get_width() == current.get_width())
+                    current.m_transposed = !current.m_transposed;
+            } else if (n > 1 && !is_vector (1)) {
+                if (current.get_width() != m_operands[1].get_height()
+                    && current.get_height() == m_operands[1].get_height())
+                    current.m_transposed = !current.m_transposed;
+            }
+        }
+
+        m_rows.resize (n + 1);
+        m_rows[0] = m_operands[0].get_height();
+        for (long unsigned int k = 0; k < n; k++) {
+            if (m_operands[k].get_height() != m_rows[k])
+                throw std::length_error ("Matrixs are not isomeric ");
+            m_rows[k + 1] = m_operands[k].get_width();
+        }
+
+        // cost[i][j] - минимум умножений для A[i..j]
+        std::vector<double> cost (n * n, 0.);
+        m_split.assign (n * n, 0);
+        for (long unsigned int length = 2; length <= n; length++)
+            for (long unsigned int i = 0; i + length <= n; i++) {
+                long unsigned int j = i + length - 1;
+                cost[i * n + j] = std::numeric_limits<double>::infinity();
+                for (long unsigned int k = i; k < j; k++) {
+                    double value = cost[i * n + k] + cost[(k + 1) * n + j]
+                                 + double (m_rows[i]) * m_rows[k + 1] * m_rows[j + 1];
+                    if (value < cost[i * n + j]) {
+                        cost[i * n + j] = value;
+                        m_split[i * n + j] = k;
+                    }
+                }
+            }
+        m_cost = cost[n - 1];
+    }
+
+    long unsigned int chain::get_size() const {
+        return m_operands.size();
+    }
+
+    double chain::get_cost() const {
+        return m_cost;
+    }
+
+    double chain::get_naive_cost() const {
+        double result = 0.;
+        for (long unsigned int k = 1; k < m_operands.size(); k++)
+            result += double (m_rows[0]) * m_rows[k] * m_rows[k + 1];
+        return result;
+    }
+
+    matrix chain::evaluate() const {
+        long unsigned int n = m_operands.size();
+        matrix result (m_rows[n], m_rows[0]);
+
+        auto leaf = [this] (long unsigned int k) {
+            const operand& current = m_operands[k];
+            long unsigned int width = current.m_matrix.m_width;
+            if (current.m_transposed)
+                return _view {current.m_matrix.m_data, 1UL, width};
+            return _view {current.m_matrix.m_data, width, 1UL};
+        };
+
+        if (n == 1) {
+            _view A = leaf (0);
+            for (long unsigned int i = 0; i < m_rows[0]; i++)
+                for (long unsigned int j = 0; j < m_rows[1]; j++)
+                    result.m_data[i * m_rows[1] + j] = A.data[i * A.row + j * A.col];
+            return result;
+        }
+
+        // обход плана: промежуточные результаты в буферах, корень - сразу в result
+        _workspace pool;
+        std::function<void (long unsigned int, long unsigned int, double*)> run;
+        run = [this, n, &leaf, &pool, &run] (long unsigned int i, long unsigned int j, double* out) {
+            long unsigned int k = m_split[i * n + j];
+            std::vector<double> left, right;
+            _view X, Y;
+            if (i == k)
+                X = leaf (i);
+            else {
+                left = pool.acquire (m_rows[i] * m_rows[k + 1]);
+                run (i, k, left.data());
+                X = _view {left.data(), m_rows[k + 1], 1UL};
+            }
+            if (k + 1 == j)
+                Y = leaf (j);
+            else {
+                right = pool.acquire (m_rows[k + 1] * m_rows[j + 1]);
+                run (k + 1, j, right.data());
+                Y = _view {right.data(), m_rows[j + 1], 1UL};
+            }
+            gemm (X, Y, out, m_rows[i], m_rows[k + 1], m_rows[j + 1]);
+            if (i != k)
+                pool.release (std::move (left));
+            if (k + 1 != j)
+                pool.release (std::move (right));
+        };
+        run (0, n - 1, result.m_data);
+        return result;
+    }
+
+    void chain::print (std::ostream& out, long unsigned int i, long unsigned int j) const {
+        if (i == j) {
+            out << "A" << i << (m_operands[i].m_transposed? "^T": "");
+            return;
+        }
+        long unsigned int k = m_split[i * m_operands.size() + j];
+        out << "(";
+        print (out, i, k);
+        out << " ";
+        print (out, k + 1, j);
+        out << ")";
+    }
+
+
+    // внешние функции
+    matrix multiply (const std::initializer_list<operand> &list) {
+        return chain (list).evaluate();
+    }
+
+
+    // стейтмент вывода
+    std::ostream& operator<< (std::ostream& out, const chain& C) {
+        C.print (out, 0, C.m_operands.size() - 1);
+        out << " [" << C.m_cost << " / " << C.get_naive_cost() << "]";
+        return out;
+    }
+}
+
+
+#endif /* CHAIN_CPP */
@@ -0,0 +1,62 @@
+#ifndef CHAIN_HPP
+#define CHAIN_HPP
+
+
+#include "matrix.hpp"
+#include <iostream>
+#include <initializer_list>
+#include <vector>
+
+
+namespace linear {
+    // сомножитель цепочки: ссылка на матрицу без копирования
+    class operand {
+        friend class chain;
+
+        private:
+            const matrix& m_matrix;
+            bool m_transposed;
+
+        public:
+            operand (const matrix&, bool transposed = false);
+
+            long unsigned int get_height() const;
+            long unsigned int get_width() const;
+    };
+
+    operand transposed (const matrix&);
+
+
+    /* произведение A0 * A1 * ... * An-1 с оптимальной расстановкой скобок.
+       Вектор (строка или столбец) ориентируется по соседям; транспонирование
+       учитывается шагами, без копирования. Матрицы должны жить дольше цепочки */
+    class chain {
+        // стейтмент вывода
+        friend std::ostream& operator<< (std::ostream&, const chain&);
+
+        private:
+            std::vector<operand> m_operands;
+            std::vector<long unsigned int> m_rows;   // rows[k] x rows[k + 1] - форма k-го сомножителя
+            std::vector<long unsigned int> m_split;  // split[i * n + j] - последнее умножение на [i, j]
+            double m_cost;                           // умножений-сложений по плану
+
+            void plan();
+            void print (std::ostream&, long unsigned int, long unsigned int) const;
+
+        public:
+            chain (const std::initializer_list<operand> &list);
+            explicit chain (const std::vector<operand>&);
+
+            // вспомогательные
+            long unsigned int get_size() const;
+            double get_cost() const;
+            double get_naive_cost() const; // слева направо
+
+            matrix evaluate() const;
+    };
+
+    matrix multiply (const std::initializer_list<operand> &list);
+}
+
+
+#endif /* CHAIN_HPP */
@@ -0,0 +1,197 @@
+#ifndef ELEMENTWISE_HPP
+#define ELEMENTWISE_HPP
+
+
+#include "matrix.hpp"
+#include "vector.hpp"
+#include "parallel.hpp"
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+
+namespace linear {
+    /* первый параметр и число параметров функции или лямбды;
+       для обобщённых лямбд (auto) не определяются */
+    template <class F, class = void>
+    struct _signature {
+        typedef void first;
+        static const long unsigned int arity = 0;
+    };
+
+    template <class R, class A, class... Rest>
+    struct _signature<R (*) (A, Rest...), void> {
+        typedef A first;
+        static const long unsigned int arity = 1 + sizeof... (Rest);
+    };
+
+    template <class C, class R, class A, class... Rest>
+    struct _signature<R (C::*) (A, Rest...), void>: _signature<R (*) (A, Rest...)> {};
+
+    template <class C, class R, class A, class... Rest>
+    struct _signature<R (C::*) (A, Rest...) const, void>: _signature<R (*) (A, Rest...)> {};
+
+    template <class F>
+    struct _signature<F, std::void_t<decltype (&F::operator())>>: _signature<decltype (&F::operator())> {};
+
+    /* поэлементные примитивы с пользовательскими функциями.
+       Функция получает значения элементов f(a, b, ...), а если её первый
+       параметр объявлен как long unsigned int и параметров на один больше
+       - индекс и значения f(i, a, b, ...). Индекс сквозной по строкам:
+       i = row * width + col. Проход один, без operator[] и проверок на
+       элемент; тело встраивается и векторизуется компилятором */
+    class _elementwise {
+        public:
+            // длина блока свёртки; разбиение не зависит от числа потоков
+            static const long unsigned int block = 1024;
+
+            static const double* data (const matrix& M) {
+                return M.m_data;
+            }
+
+            static double* data (matrix& M) {
+                M.touch();
+                return M.m_data;
+            }
+
+            static long unsigned int length (const matrix& M) {
+                return M.m_width * M.m_height;
+            }
+
+            // неинициализированная матрица той же формы и типа
+            static matrix shaped (const matrix& M) {
+                return matrix (M.m_width, M.m_height);
+            }
+
+            static vector shaped (const vector& V) {
+                vector result (V.m_width * V.m_height);
+                result.m_width = V.m_width;
+                result.m_height = V.m_height;
+                return result;
+            }
+
+            template <class... M>
+            static void check (const matrix& A, const M&... rest) {
+                bool same = (... && (A.m_width == rest.m_width && A.m_height == rest.m_height));
+                if (!same)
+                    throw std::length_error ("Matrix's sizes are different ");
+            }
+
+            template <class F, class... V>
+            static auto call (F& f, long unsigned int i, V... values) {
+                typedef _signature<typename std::decay<F>::type> signature;
+                if constexpr (std::is_same<typename std::decay<typename signature::first>::type, long unsigned int>::value
+                              && signature::arity == sizeof... (V) + 1)
+                    return f (i, values...);
+                else {
+                    static_assert (std::is_invocable<F&, V...>::value,
+                                   "f takes one value per operand, or long unsigned int index and the values");
+                    return f (values...);
+                }
+            }
+    };
+
+
+    // result[i] = f(A[i], rest[i]...)
+    template <class F, class T, class... M>
+    T zip_with (F f, const T& A, const M&... rest) {
+        static_assert (std::is_base_of<matrix, T>::value, "zip_with expects matrix or vector");
+        _elementwise::check (A, rest...);
+        T result = _elementwise::shaped (A);
+        double* out = _elementwise::data (result);
+        const double* in = _elementwise::data (A);
+        auto inputs = std::make_tuple (_elementwise::data (rest)...);
+        parallel::for_range (_elementwise::length (A), 1UL, [&f, out, in, inputs] (long unsigned int begin, long unsigned int end) {
+            std::apply ([&f, out, in, begin, end] (auto... other) {
+                for (long unsigned int i = begin; i < end; i++)
+                    out[i] = _elementwise::call (f, i, in[i], other[i]...);
+            }, inputs);
+        });
+        return result;
+    }
+
+    // result[i] = f(A[i])
+    template <class F, class T>
+    T map (const T& A, F f) {
+        return zip_with (f, A);
+    }
+
+    // A[i] = f(A[i], rest[i]...) на месте
+    template <class F, class T, class... M>
+    T& transform (T& A, F f, const M&... rest) {
+        static_assert (std::is_base_of<matrix, T>::value, "transform expects matrix or vector");
+        _elementwise::check (A, rest...);
+        double* out = _elementwise::data (A);
+        auto inputs = std::make_tuple (_elementwise::data (rest)...);
+        parallel::for_range (_elementwise::length (A), 1UL, [&f, out, inputs] (long unsigned int begin, long unsigned int end) {
+            std::apply ([&f, out, begin, end] (auto... other) {
+                for (long unsigned int i = begin; i < end; i++)
+                    out[i] = _elementwise::call (f, i, out[i], other[i]...);
+            }, inputs);
+        });
+        return A;
+    }
+
+    /* свёртка reduce(init, f(A[i], rest[i]...)) по всем i.
+       reduce должна быть ассоциативной и коммутативной: внутри блока 8
+       полос, и порядок операндов не сохраняется. Блоки складываются по
+       порядку, поэтому результат не зависит от числа потоков. Тип
+       накопителя - тип init, например норма с argmax: f(i, a) даёт
+       (a^2, |a|, i), при равных модулях reduce берёт меньший индекс */
+    template <class T, class R, class F, class... M>
+    T transform_reduce (T init, R reduce, F f, const matrix& A, const M&... rest) {
+        _elementwise::check (A, rest...);
+        long unsigned int n = _elementwise::length (A);
+        if (n == 0)
+            return init;
+        const double* in = _elementwise::data (A);
+        auto inputs = std::make_tuple (_elementwise::data (rest)...);
+        const long unsigned int block = _elementwise::block;
+        long unsigned int blocks = (n + block - 1) / block;
+        std::vector<T> partial (blocks, init);
+
+        parallel::for_range (blocks, block, [&] (long unsigned int first, long unsigned int last) {
+            std::apply ([&] (auto... other) {
+                auto term = [&] (long unsigned int i) {
+                    return T (_elementwise::call (f, i, in[i], other[i]...));
+                };
+                for (long unsigned int k = first; k < last; k++) {
+                    long unsigned int begin = k * block;
+                    long unsigned int end = (begin + block < n)? begin + block: n;
+                    long unsigned int i = begin;
+                    T value = term (i++);
+                    if (end - begin >= 8) {
+                        T lane[7] = {term (i), term (i + 1), term (i + 2), term (i + 3),
+                                     term (i + 4), term (i + 5), term (i + 6)};
+                        i += 7;
+                        for (; i + 8 <= end; i += 8) {
+                            value = reduce (value, term (i));
+                            for (long unsigned int l = 0; l < 7; l++)
+                                lane[l] = reduce (lane[l], term (i + 1 + l));
+                        }
+                        for (long unsigned int l = 0; l < 7; l++)
+                            value = reduce (value, lane[l]);
+                    }
+                    for (; i < end; i++)
+                        value = reduce (value, term (i));
+                    partial[k] = value;
+                }
+            }, inputs);
+        });
+
+        T result = init;
+        for (auto &value : partial)
+            result = reduce (result, value);
+        return result;
+    }
+
+    // reduce(init, A[i]) по всем i
+    template <class T, class R>
+    T reduce (const matrix& A, T init, R op) {
+        return transform_reduce (init, op, [] (double a) { return a; }, A);
+    }
+}
+
+
+#endif /* ELEMENTWISE_HPP */
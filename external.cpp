@@ -0,0 +1,204 @@
+#ifndef EXTERNAL_CPP
+#define EXTERNAL_CPP
+
+
+#include "external.hpp"
+#include "parallel.hpp"
+#include <stdexcept>
+#include <cmath>
+#include <utility>
+
+
+namespace linear {
+    matrix_view::matrix_view (double* data, long unsigned int width, long unsigned int height, long unsigned int stride)
+    : m_data (data), m_width (width), m_height (height), m_stride (stride) {
+        if (data == nullptr)
+            throw std::invalid_argument ("Invalid buffer ");
+        if (height < 1)
+            throw std::invalid_argument ("Invalid matrix height ");
+        if (width < 1)
+            throw std::invalid_argument ("Invalid matrix width ");
+        if (stride < width)
+            throw std::invalid_argument ("Invalid row stride ");
+    }
+
+
+    // вспомогательные
+    long unsigned int matrix_view::get_width() const {
+        return m_width;
+    }
+
+    long unsigned int matrix_view::get_height() const {
+        return m_height;
+    }
+
+    long unsigned int matrix_view::get_stride() const {
+        return m_stride;
+    }
+
+    double* matrix_view::get_data() const {
+        return m_data;
+    }
+
+    matrix_view matrix_view::block (long unsigned int row, long unsigned int col,
+                                    long unsigned int width, long unsigned int height) const {
+        if (row + height > m_height || col + width > m_width)
+            throw std::out_of_range ("Index is out of range ");
+        return matrix_view (m_data + row * m_stride + col, width, height, m_stride);
+    }
+
+    matrix matrix_view::borrow() const {
+        if (m_stride != m_width)
+            throw std::invalid_argument ("Strided view is not contiguous ");
+        return matrix (m_data, m_width, m_height);
+    }
+
+    matrix matrix_view::get_matrix() const {
+        matrix result (m_width, m_height);
+        double* out = result.m_data;
+        for (long unsigned int i = 0; i < m_height; i++)
+            for (long unsigned int j = 0; j < m_width; j++)
+                out[i * m_width + j] = m_data[i * m_stride + j];
+        return result;
+    }
+
+
+    // индексирование
+    double& matrix_view::operator() (long unsigned int row, long unsigned int col) const {
+        if (row >= m_height || col >= m_width)
+            throw std::out_of_range ("Index is out of range ");
+        return m_data[row * m_stride + col];
+    }
+
+
+    // внешние функции
+    matrix_view view (double* data, long unsigned int width, long unsigned int height, long unsigned int stride) {
+        return matrix_view (data, width, height, stride);
+    }
+
+    /* запись через окно не видна кэшу матрицы - он сбрасывается заранее */
+    matrix_view view (matrix& M) {
+        M.touch();
+        return matrix_view (M.m_data, M.m_width, M.m_height, M.m_width);
+    }
+
+    /* пересечение занятых окнами диапазонов памяти, включая промежутки stride */
+    static bool overlaps (const matrix_view& X, const matrix_view& Y) {
+        if (X.get_width() == 0 || X.get_height() == 0 || Y.get_width() == 0 || Y.get_height() == 0)
+            return false;
+        const double* x = X.get_data();
+        const double* y = Y.get_data();
+        const double* x_end = x + (X.get_height() - 1) * X.get_stride() + X.get_width();
+        const double* y_end = y + (Y.get_height() - 1) * Y.get_stride() + Y.get_width();
+        return x < y_end && y < x_end;
+    }
+
+    // C совпадает с X поэлементно: запись в элемент читает только его же
+    static bool same (const matrix_view& X, const matrix_view& C) {
+        return X.get_data() == C.get_data() && (X.get_stride() == C.get_stride() || X.get_height() < 2);
+    }
+
+    /* i-k-j по строкам C; C не должна пересекаться с A и B */
+    void gemm (const matrix_view& A, const matrix_view& B, const matrix_view& C) {
+        long unsigned int rows = A.get_height(), inner = A.get_width(), cols = B.get_width();
+        if (B.get_height() != inner)
+            throw std::length_error ("Matrixs are not isomeric ");
+        if (C.get_height() != rows || C.get_width() != cols)
+            throw std::length_error ("Matrix's sizes are different ");
+        if (overlaps (C, A) || overlaps (C, B))
+            throw std::invalid_argument ("Result aliases operand ");
+        const double* a = A.get_data();
+        const double* b = B.get_data();
+        double* c = C.get_data();
+        long unsigned int lda = A.get_stride(), ldb = B.get_stride(), ldc = C.get_stride();
+        parallel::for_range (rows, inner * cols, [=] (long unsigned int begin, long unsigned int end) {
+            for (long unsigned int i = begin; i < end; i++) {
+                double* c_row = c + i * ldc;
+                for (long unsigned int j = 0; j < cols; j++)
+                    c_row[j] = 0.;
+                for (long unsigned int k = 0; k < inner; k++) {
+                    double value = a[i * lda + k];
+                    const double* b_row = b + k * ldb;
+                    for (long unsigned int j = 0; j < cols; j++)
+                        c_row[j] += value * b_row[j];
+                }
+            }
+        });
+    }
+
+    /* C может совпадать с A или B целиком; частичное пересечение
+       читало бы строки, уже записанные другим исполнителем */
+    void add (const matrix_view& A, const matrix_view& B, const matrix_view& C) {
+        long unsigned int rows = A.get_height(), cols = A.get_width();
+        if (B.get_height() != rows || B.get_width() != cols || C.get_height() != rows || C.get_width() != cols)
+            throw std::length_error ("Matrix's sizes are different ");
+        if ((overlaps (C, A) && !same (A, C)) || (overlaps (C, B) && !same (B, C)))
+            throw std::invalid_argument ("Result aliases operand ");
+        const double* a = A.get_data();
+        const double* b = B.get_data();
+        double* c = C.get_data();
+        long unsigned int lda = A.get_stride(), ldb = B.get_stride(), ldc = C.get_stride();
+        parallel::for_range (rows, cols, [=] (long unsigned int begin, long unsigned int end) {
+            for (long unsigned int i = begin; i < end; i++)
+                for (long unsigned int j = 0; j < cols; j++)
+                    c[i * ldc + j] = a[i * lda + j] + b[i * ldb + j];
+        });
+    }
+
+    /* исключение Гаусса с выбором ведущего по столбцу; перестановки строк
+       применяются и к A, и к B, поэтому A остаётся множителями PA = LU */
+    void solve (const matrix_view& A, const matrix_view& B) {
+        long unsigned int n = A.get_height();
+        if (A.get_width() != n)
+            throw std::length_error ("Matrix is not square ");
+        if (B.get_height() != n)
+            throw std::length_error ("Matrixs are not isomeric ");
+        if (overlaps (A, B))
+            throw std::invalid_argument ("Result aliases operand ");
+        double* a = A.get_data();
+        double* b = B.get_data();
+        long unsigned int lda = A.get_stride(), ldb = B.get_stride(), cols = B.get_width();
+
+        for (long unsigned int k = 0; k < n; k++) {
+            long unsigned int pivot = k;
+            for (long unsigned int i = k + 1; i < n; i++)
+                if (std::fabs (a[i * lda + k]) > std::fabs (a[pivot * lda + k]))
+                    pivot = i;
+            if (a[pivot * lda + k] == 0.)
+                throw singular_error();
+            if (pivot != k) {
+                for (long unsigned int j = 0; j < n; j++)
+                    std::swap (a[k * lda + j], a[pivot * lda + j]);
+                for (long unsigned int j = 0; j < cols; j++)
+                    std::swap (b[k * ldb + j], b[pivot * ldb + j]);
+            }
+            const double* a_k = a + k * lda;
+            const double* b_k = b + k * ldb;
+            for (long unsigned int i = k + 1; i < n; i++) {
+                double* a_i = a + i * lda;
+                double* b_i = b + i * ldb;
+                double l = a_i[k] / a_k[k];
+                a_i[k] = l;
+                for (long unsigned int j = k + 1; j < n; j++)
+                    a_i[j] -= l * a_k[j];
+                for (long unsigned int j = 0; j < cols; j++)
+                    b_i[j] -= l * b_k[j];
+            }
+        }
+        for (long unsigned int step = 0; step < n; step++) {
+            long unsigned int i = n - 1 - step;
+            const double* a_i = a + i * lda;
+            double* b_i = b + i * ldb;
+            for (long unsigned int k = i + 1; k < n; k++) {
+                const double* b_k = b + k * ldb;
+                for (long unsigned int j = 0; j < cols; j++)
+                    b_i[j] -= a_i[k] * b_k[j];
+            }
+            for (long unsigned int j = 0; j < cols; j++)
+                b_i[j] /= a_i[i];
+        }
+    }
+}
+
+
+#endif /* EXTERNAL_CPP */
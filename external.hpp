@@ -0,0 +1,47 @@
+#ifndef EXTERNAL_HPP
+#define EXTERNAL_HPP
+
+
+#include "matrix.hpp"
+
+
+namespace linear {
+    /* окно во внешнюю память по строкам: элемент (i, j) = data[i * stride + j].
+       Не владеет памятью и не копирует её */
+    class matrix_view {
+        private:
+            double* m_data;
+            long unsigned int m_width;
+            long unsigned int m_height;
+            long unsigned int m_stride; // расстояние между строками, >= width
+
+        public:
+            matrix_view (double* data, long unsigned int width, long unsigned int height, long unsigned int stride);
+
+            // вспомогательные
+            long unsigned int get_width() const;
+            long unsigned int get_height() const;
+            long unsigned int get_stride() const;
+            double* get_data() const;
+            matrix_view block (long unsigned int row, long unsigned int col,
+                               long unsigned int width, long unsigned int height) const; // подматрица без копии
+            matrix borrow() const; // матрица над той же памятью, только при stride == width
+            matrix get_matrix() const; // плотная копия
+
+            // индексирование
+            double& operator() (long unsigned int row, long unsigned int col) const;
+    };
+
+    matrix_view view (double* data, long unsigned int width, long unsigned int height, long unsigned int stride);
+    matrix_view view (matrix&);
+
+    /* ядра над окнами; результат пишется в C без выделения памяти.
+       Пересечение C с операндом по памяти - invalid_argument, кроме
+       add с C, совпадающим с A или B целиком. В solve A и B не пересекаются */
+    void gemm (const matrix_view& A, const matrix_view& B, const matrix_view& C); // C = A B
+    void add (const matrix_view& A, const matrix_view& B, const matrix_view& C);  // C = A + B
+    void solve (const matrix_view& A, const matrix_view& B); // LU с выбором ведущего на месте: A <- LU, B <- X
+}
+
+
+#endif /* EXTERNAL_HPP */
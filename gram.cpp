@@ -0,0 +1,281 @@
+#ifndef GRAM_CPP
+#define GRAM_CPP
+
+
+#include "gram.hpp"
+#include "parallel.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <utility>
+#include <mutex>
+
+
+namespace linear {
+    /* t-я строка треугольника: 0, d-1, 1, d-2, ... - соседние пары
+       уравнивают работу, поэтому равные куски for_range равны по стоимости */
+    static long unsigned int balanced (long unsigned int t, long unsigned int d) {
+        return (t % 2 == 0)? t / 2: d - 1 - t / 2;
+    }
+
+    /* M[i][j] += sum_r X[r][i] X[r][j], j >= i, для строк треугольника [first, last).
+       Пачка режется на блоки, помещающиеся в L2; в блоке 4 строки X за проход,
+       так что отрезок строки M читается и пишется раз на 4 ранга */
+    static void syrk (double* __restrict M, const double* __restrict X, long unsigned int rows,
+                      long unsigned int stride, long unsigned int d,
+                      long unsigned int first, long unsigned int last) {
+        long unsigned int block = std::min (std::max (65536UL / d, 16UL), 256UL);
+        for (long unsigned int r0 = 0; r0 < rows; r0 += block) {
+            long unsigned int r1 = std::min (rows, r0 + block);
+            for (long unsigned int t = first; t < last; t++) {
+                long unsigned int i = balanced (t, d);
+                double* m = M + i * d;
+                long unsigned int r = r0;
+                for (; r + 4 <= r1; r += 4) {
+                    const double* x0 = X + r * stride;
+                    const double* x1 = x0 + stride;
+                    const double* x2 = x1 + stride;
+                    const double* x3 = x2 + stride;
+                    double a0 = x0[i], a1 = x1[i], a2 = x2[i], a3 = x3[i];
+                    for (long unsigned int j = i; j < d; j++)
+                        m[j] += a0 * x0[j] + a1 * x1[j] + a2 * x2[j] + a3 * x3[j];
+                }
+                for (; r < r1; r++) {
+                    const double* x = X + r * stride;
+                    double a = x[i];
+                    for (long unsigned int j = i; j < d; j++)
+                        m[j] += a * x[j];
+                }
+            }
+        }
+    }
+
+
+    gram_accumulator::gram_accumulator (long unsigned int dim, bool center)
+    : m_dim (dim), m_center (center), m_count (0), m_mean (dim, 0.), m_sum (dim * dim, 0.) {
+        if (dim == 0)
+            throw std::invalid_argument ("Invalid matrix size ");
+    }
+
+    /* слияние частичного результата: mean, sum (nullptr - нули) по count строкам */
+    void gram_accumulator::combine (const double* mean, const double* sum, long unsigned int count) {
+        if (count == 0)
+            return;
+        long unsigned int d = m_dim;
+        double total = double (m_count) + double (count);
+        std::vector<double> delta (d);
+        for (long unsigned int i = 0; i < d; i++)
+            delta[i] = mean[i] - m_mean[i];
+
+        double factor = m_center? double (m_count) * double (count) / total: 0.;
+        for (long unsigned int i = 0; i < d; i++) {
+            double* m = m_sum.data() + i * d;
+            const double* s = (sum == nullptr)? nullptr: sum + i * d;
+            double scale = factor * delta[i];
+            if (s != nullptr)
+                for (long unsigned int j = i; j < d; j++)
+                    m[j] += s[j];
+            if (scale != 0.)
+                for (long unsigned int j = i; j < d; j++)
+                    m[j] += scale * delta[j];
+        }
+        for (long unsigned int i = 0; i < d; i++)
+            m_mean[i] += delta[i] * (double (count) / total);
+        m_count += count;
+    }
+
+    void gram_accumulator::absorb (const double* rows, long unsigned int count, long unsigned int stride, bool threaded) {
+        long unsigned int d = m_dim;
+        auto run = [d, threaded] (double* M, const double* X, long unsigned int n, long unsigned int ld) {
+            if (threaded)
+                parallel::for_range (d, n * d / 2, [=] (long unsigned int first, long unsigned int last) {
+                    syrk (M, X, n, ld, d, first, last);
+                });
+            else
+                syrk (M, X, n, ld, d, 0, d);
+        };
+
+        std::vector<double> mean (d), centered, local;
+        for (long unsigned int r0 = 0; r0 < count; r0 += (m_center? chunk: count)) {
+            long unsigned int n = m_center? std::min (chunk, count - r0): count;
+            const double* X = rows + r0 * stride;
+            std::fill (mean.begin(), mean.end(), 0.);
+            for (long unsigned int r = 0; r < n; r++)
+                for (long unsigned int j = 0; j < d; j++)
+                    mean[j] += X[r * stride + j];
+            for (long unsigned int j = 0; j < d; j++)
+                mean[j] /= double (n);
+
+            if (!m_center) {
+                run (m_sum.data(), X, n, stride);
+                combine (mean.data(), nullptr, n);
+            } else if (n == 1) {
+                combine (mean.data(), nullptr, 1);
+            } else {
+                centered.resize (n * d);
+                local.assign (d * d, 0.);
+                for (long unsigned int r = 0; r < n; r++)
+                    for (long unsigned int j = 0; j < d; j++)
+                        centered[r * d + j] = X[r * stride + j] - mean[j];
+                run (local.data(), centered.data(), n, d);
+                combine (mean.data(), local.data(), n);
+            }
+        }
+    }
+
+    // вспомогательные
+    long unsigned int gram_accumulator::get_dim() const {
+        return m_dim;
+    }
+
+    long unsigned int gram_accumulator::get_count() const {
+        return m_count;
+    }
+
+    bool gram_accumulator::get_center() const {
+        return m_center;
+    }
+
+    vector gram_accumulator::mean() const {
+        vector result (m_dim, 0.);
+        for (long unsigned int j = 0; j < m_dim; j++)
+            result[j] = m_mean[j];
+        return result;
+    }
+
+    matrix gram_accumulator::gram() const {
+        long unsigned int d = m_dim;
+        matrix result (d, d);
+        for (long unsigned int i = 0; i < d; i++)
+            for (long unsigned int j = i; j < d; j++)
+                result.m_data[i * d + j] = result.m_data[j * d + i] = m_sum[i * d + j];
+        return result;
+    }
+
+    matrix gram_accumulator::covariance (long unsigned int ddof) const {
+        if (m_count <= ddof)
+            throw std::invalid_argument ("Not enough rows ");
+        long unsigned int d = m_dim;
+        double n = double (m_count), scale = 1. / (n - double (ddof));
+        matrix result (d, d);
+        for (long unsigned int i = 0; i < d; i++)
+            for (long unsigned int j = i; j < d; j++) {
+                double value = m_sum[i * d + j];
+                if (!m_center)
+                    value -= n * m_mean[i] * m_mean[j];
+                result.m_data[i * d + j] = result.m_data[j * d + i] = value * scale;
+            }
+        return result;
+    }
+
+    // накопление
+    void gram_accumulator::add (const vector& row) {
+        if (row.m_width * row.m_height != m_dim)
+            throw std::length_error ("Matrix's sizes are different ");
+        absorb (row.m_data, 1, m_dim, true);
+    }
+
+    void gram_accumulator::add (const matrix& rows) {
+        if (rows.m_width != m_dim)
+            throw std::length_error ("Matrix's sizes are different ");
+        absorb (rows.m_data, rows.m_height, rows.m_width, true);
+    }
+
+    void gram_accumulator::add (const double* rows, long unsigned int count, long unsigned int stride) {
+        if (stride < m_dim)
+            throw std::length_error ("Invalid matrix size ");
+        absorb (rows, count, stride, true);
+    }
+
+    /* неполная последняя строка - ошибка, полные строки перед ней учтены */
+    long unsigned int gram_accumulator::read (std::istream& in) {
+        long unsigned int before = m_count;
+        std::vector<double> buffer;
+        buffer.reserve (chunk * m_dim);
+        double value;
+        while (in >> value) {
+            buffer.push_back (value);
+            if (buffer.size() == chunk * m_dim) {
+                absorb (buffer.data(), chunk, m_dim, true);
+                buffer.clear();
+            }
+        }
+        absorb (buffer.data(), buffer.size() / m_dim, m_dim, true);
+        if (!in.eof())
+            throw std::invalid_argument ("Invalid stream ");
+        if (buffer.size() % m_dim != 0)
+            throw std::length_error ("Matrix's sizes are different ");
+        return m_count - before;
+    }
+
+    long unsigned int gram_accumulator::read_binary (std::istream& in) {
+        long unsigned int before = m_count;
+        std::vector<double> buffer (chunk * m_dim);
+        long unsigned int size = buffer.size() * sizeof (double), got;
+        do {
+            in.read (reinterpret_cast<char*> (buffer.data()), size);
+            got = in.gcount() / sizeof (double);
+            absorb (buffer.data(), got / m_dim, m_dim, true);
+        } while (got * sizeof (double) == size);
+        if (got % m_dim != 0 || in.gcount() % sizeof (double) != 0)
+            throw std::length_error ("Matrix's sizes are different ");
+        return m_count - before;
+    }
+
+    void gram_accumulator::merge (const gram_accumulator& other) {
+        if (other.m_dim != m_dim)
+            throw std::length_error ("Matrix's sizes are different ");
+        if (other.m_center != m_center)
+            throw std::invalid_argument ("Accumulators are not compatible ");
+        if (&other == this) {
+            gram_accumulator copy (other);
+            combine (copy.m_mean.data(), copy.m_sum.data(), copy.m_count);
+        } else
+            combine (other.m_mean.data(), other.m_sum.data(), other.m_count);
+    }
+
+    void gram_accumulator::clear() {
+        m_count = 0;
+        std::fill (m_mean.begin(), m_mean.end(), 0.);
+        std::fill (m_sum.begin(), m_sum.end(), 0.);
+    }
+
+    /* при rows >> dim каждому потоку свой треугольник: d^2 памяти на поток,
+       зато нет синхронизации; иначе потоки делят строки треугольника */
+    gram_accumulator gram_accumulator::accumulate (const matrix& A, bool center) {
+        long unsigned int d = A.m_width, rows = A.m_height;
+        gram_accumulator result (d, center);
+        if (parallel::get_workers() < 2 || rows < 8 * d * parallel::get_workers()) {
+            result.add (A);
+            return result;
+        }
+
+        std::vector<std::pair<long unsigned int, gram_accumulator>> parts;
+        std::mutex lock;
+        parallel::for_range (rows, d * d / 2 + 1, [&] (long unsigned int begin, long unsigned int end) {
+            gram_accumulator local (d, center);
+            local.absorb (A.m_data + begin * d, end - begin, d, false);
+            std::lock_guard<std::mutex> guard (lock);
+            parts.emplace_back (begin, std::move (local));
+        });
+        // порядок слияния не зависит от расписания потоков
+        std::sort (parts.begin(), parts.end(), [] (const std::pair<long unsigned int, gram_accumulator>& a,
+                                                   const std::pair<long unsigned int, gram_accumulator>& b) {
+            return a.first < b.first;
+        });
+        for (auto &part : parts)
+            result.merge (part.second);
+        return result;
+    }
+
+
+    matrix gram (const matrix& A) {
+        return gram_accumulator::accumulate (A, false).gram();
+    }
+
+    matrix covariance (const matrix& A, long unsigned int ddof) {
+        return gram_accumulator::accumulate (A, true).covariance (ddof);
+    }
+}
+
+
+#endif /* GRAM_CPP */
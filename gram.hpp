@@ -0,0 +1,79 @@
+#ifndef GRAM_HPP
+#define GRAM_HPP
+
+
+#include "matrix.hpp"
+#include "vector.hpp"
+#include <iostream>
+#include <vector>
+
+
+namespace linear {
+    /* накопление A^T A (или ковариации) по строкам A, приходящим пачками.
+       Считается только верхний треугольник, нижний отражается при выдаче.
+       С центрированием каждая пачка центрируется по своему среднему и
+       вливается формулой Чана: M = Ma + Mb + d d^T na nb / n, d = mb - ma */
+    class gram_accumulator {
+        private:
+            long unsigned int m_dim;
+            bool m_center;
+            long unsigned int m_count;   // строк
+            std::vector<double> m_mean;  // среднее по строкам
+            std::vector<double> m_sum;   // dim x dim, заполнен верхний треугольник
+
+            // строк в пачке при центрировании и чтении из потока
+            static constexpr long unsigned int chunk = 4096;
+
+            void absorb (const double* rows, long unsigned int count, long unsigned int stride, bool threaded);
+            void combine (const double* mean, const double* sum, long unsigned int count);
+
+        public:
+            explicit gram_accumulator (long unsigned int dim, bool center = false);
+
+            // вспомогательные
+            long unsigned int get_dim() const;
+            long unsigned int get_count() const;
+            bool get_center() const;
+            vector mean() const;
+            matrix gram() const;   // sum (x - mean)(x - mean)^T при центрировании, иначе sum x x^T
+            matrix covariance (long unsigned int ddof = 1) const;
+
+            // накопление
+            void add (const vector& row);
+            void add (const matrix& rows); // каждая строка - наблюдение, ширина dim
+            void add (const double* rows, long unsigned int count, long unsigned int stride);
+            template <class Iterator>
+            void add (Iterator begin, Iterator end); // *it индексируется [0, dim)
+            long unsigned int read (std::istream&);        // текст: числа через пробелы, dim на строку
+            long unsigned int read_binary (std::istream&); // сырые double подряд
+            void merge (const gram_accumulator&);
+            void clear();
+
+            // строки A делятся между потоками, частичные суммы сливаются по порядку
+            static gram_accumulator accumulate (const matrix& A, bool center = false);
+    };
+
+    matrix gram (const matrix& A);                                // A^T A
+    matrix covariance (const matrix& A, long unsigned int ddof = 1); // по строкам-наблюдениям
+
+
+    template <class Iterator>
+    void gram_accumulator::add (Iterator begin, Iterator end) {
+        std::vector<double> buffer;
+        buffer.reserve (chunk * m_dim);
+        for (; begin != end; ++begin) {
+            const auto& row = *begin;
+            for (long unsigned int j = 0; j < m_dim; j++)
+                buffer.push_back (row[j]);
+            if (buffer.size() == chunk * m_dim) {
+                absorb (buffer.data(), chunk, m_dim, true);
+                buffer.clear();
+            }
+        }
+        if (!buffer.empty())
+            absorb (buffer.data(), buffer.size() / m_dim, m_dim, true);
+    }
+}
+
+
+#endif /* GRAM_HPP */
@@ -0,0 +1,425 @@
+#ifndef INCREMENTAL_CPP
+#define INCREMENTAL_CPP
+
+
+#include "incremental.hpp"
+#include "external.hpp"
+#include "parallel.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+namespace linear {
+    /* C += alpha A B, все плотные по строкам: A - rows x inner, B - inner x cols */
+    static void gemm_add (double* C, const double* A, const double* B, long unsigned int rows,
+                          long unsigned int inner, long unsigned int cols, double alpha) {
+        parallel::for_range (rows, inner * cols, [=] (long unsigned int begin, long unsigned int end) {
+            for (long unsigned int i = begin; i < end; i++) {
+                double* c = C + i * cols;
+                for (long unsigned int k = 0; k < inner; k++) {
+                    double a = alpha * A[i * inner + k];
+                    const double* b = B + k * cols;
+                    for (long unsigned int j = 0; j < cols; j++)
+                        c[j] += a * b[j];
+                }
+            }
+        });
+    }
+
+    static long unsigned int length (const matrix& V) {
+        return V.get_width() * V.get_height();
+    }
+
+
+    // произведение
+    maintained_product::maintained_product (const matrix& A, const matrix& B, long unsigned int period)
+    : m_a (A), m_b (B), m_c (B.get_width(), A.get_height()), m_period (period), m_count (0) {
+        if (A.get_width() != B.get_height())
+            throw std::length_error ("Matrixs are not isomeric ");
+        refactor();
+    }
+
+    void maintained_product::tick() {
+        if (m_period > 0 && ++m_count >= m_period)
+            refactor();
+    }
+
+    const matrix& maintained_product::get_left() const {
+        return m_a;
+    }
+
+    const matrix& maintained_product::get_right() const {
+        return m_b;
+    }
+
+    const matrix& maintained_product::get_product() const {
+        return m_c;
+    }
+
+    long unsigned int maintained_product::get_count() const {
+        return m_count;
+    }
+
+    double maintained_product::drift() const {
+        matrix exact (m_c.m_width, m_c.m_height, 0.);
+        gemm_add (exact.m_data, m_a.m_data, m_b.m_data, m_a.m_height, m_a.m_width, m_b.m_width, 1.);
+        double result = 0.;
+        for (long unsigned int i = 0; i < length (m_c); i++)
+            result = std::max (result, std::fabs (exact.m_data[i] - m_c.m_data[i]));
+        return result;
+    }
+
+    /* новая строка C = row B, O(n^2) */
+    void maintained_product::set_row (long unsigned int row, const vector& V) {
+        long unsigned int inner = m_a.m_width, cols = m_b.m_width;
+        if (row >= m_a.m_height)
+            throw std::out_of_range ("Index is out of range ");
+        if (length (V) != inner)
+            throw std::length_error ("Matrix's sizes are different ");
+        m_c.touch();
+        m_a.touch();
+        double* c = m_c.m_data + row * cols;
+        for (long unsigned int j = 0; j < cols; j++)
+            c[j] = 0.;
+        gemm_add (c, V.m_data, m_b.m_data, 1, inner, cols, 1.);
+        for (long unsigned int k = 0; k < inner; k++)
+            m_a.m_data[row * inner + k] = V.m_data[k];
+        tick();
+    }
+
+    /* C += (col - A[:, j]) B[j, :], ранг 1 */
+    void maintained_product::set_col (long unsigned int col, const vector& V) {
+        long unsigned int rows = m_a.m_height, inner = m_a.m_width, cols = m_b.m_width;
+        if (col >= inner)
+            throw std::out_of_range ("Index is out of range ");
+        if (length (V) != rows)
+            throw std::length_error ("Matrix's sizes are different ");
+        std::vector<double> delta (rows);
+        for (long unsigned int i = 0; i < rows; i++) {
+            delta[i] = V.m_data[i] - m_a.m_data[i * inner + col];
+            m_a.m_data[i * inner + col] = V.m_data[i];
+        }
+        m_a.touch();
+        m_c.touch();
+        gemm_add (m_c.m_data, delta.data(), m_b.m_data + col * cols, rows, 1, cols, 1.);
+        tick();
+    }
+
+    /* C += U (V B): O(k n^2) */
+    void maintained_product::update_left (const matrix& U, const matrix& V) {
+        long unsigned int rows = m_a.m_height, inner = m_a.m_width, cols = m_b.m_width, k = U.m_width;
+        if (U.m_height != rows || V.m_width != inner)
+            throw std::length_error ("Matrix's sizes are different ");
+        if (V.m_height != k)
+            throw std::length_error ("Matrixs are not isomeric ");
+        std::vector<double> W (k * cols, 0.);
+        gemm_add (W.data(), V.m_data, m_b.m_data, k, inner, cols, 1.);
+        m_a.touch();
+        m_c.touch();
+        gemm_add (m_a.m_data, U.m_data, V.m_data, rows, k, inner, 1.);
+        gemm_add (m_c.m_data, U.m_data, W.data(), rows, k, cols, 1.);
+        tick();
+    }
+
+    /* C += (A U) V: O(k n^2) */
+    void maintained_product::update_right (const matrix& U, const matrix& V) {
+        long unsigned int rows = m_a.m_height, inner = m_a.m_width, cols = m_b.m_width, k = U.m_width;
+        if (U.m_height != inner || V.m_width != cols)
+            throw std::length_error ("Matrix's sizes are different ");
+        if (V.m_height != k)
+            throw std::length_error ("Matrixs are not isomeric ");
+        std::vector<double> T (rows * k, 0.);
+        gemm_add (T.data(), m_a.m_data, U.m_data, rows, inner, k, 1.);
+        m_b.touch();
+        m_c.touch();
+        gemm_add (m_b.m_data, U.m_data, V.m_data, inner, k, cols, 1.);
+        gemm_add (m_c.m_data, T.data(), V.m_data, rows, k, cols, 1.);
+        tick();
+    }
+
+    void maintained_product::refactor() {
+        m_c.touch();
+        for (long unsigned int i = 0; i < length (m_c); i++)
+            m_c.m_data[i] = 0.;
+        gemm_add (m_c.m_data, m_a.m_data, m_b.m_data, m_a.m_height, m_a.m_width, m_b.m_width, 1.);
+        m_count = 0;
+    }
+
+
+    // обратная матрица
+    maintained_inverse::maintained_inverse (const matrix& A, long unsigned int period)
+    : m_a (A), m_inverse (A.get_width(), A.get_height()), m_period (period), m_count (0) {
+        if (A.get_width() != A.get_height())
+            throw std::length_error ("Matrix is not square ");
+        refactor();
+    }
+
+    // A^-1 во временную матрицу: при вырождении inverse не меняется
+    void maintained_inverse::invert (const matrix& A, matrix& inverse) {
+        long unsigned int n = A.m_width;
+        matrix LU (A), X (n, n, 0.);
+        for (long unsigned int i = 0; i < n; i++)
+            X.m_data[i * n + i] = 1.;
+        linear::solve (view (LU), view (X));
+        inverse = std::move (X);
+    }
+
+    /* новое состояние собрано во временных и принимается целиком;
+       плановый пересчёт идёт до записи, его исключение объект не меняет */
+    void maintained_inverse::commit (matrix& A, matrix& inverse) {
+        bool due = m_period > 0 && m_count + 1 >= m_period;
+        if (due)
+            invert (A, inverse);
+        m_a = std::move (A);
+        m_inverse = std::move (inverse);
+        m_count = due? 0: m_count + 1;
+    }
+
+    const matrix& maintained_inverse::get_matrix() const {
+        return m_a;
+    }
+
+    const matrix& maintained_inverse::get_inverse() const {
+        return m_inverse;
+    }
+
+    long unsigned int maintained_inverse::get_count() const {
+        return m_count;
+    }
+
+    vector maintained_inverse::solve (const vector& b) const {
+        long unsigned int n = m_a.m_width;
+        if (length (b) != n)
+            throw std::length_error ("Matrixs are not isomeric ");
+        vector x (b);
+        x.touch();
+        for (long unsigned int i = 0; i < n; i++) {
+            double sum = 0.;
+            for (long unsigned int j = 0; j < n; j++)
+                sum += m_inverse.m_data[i * n + j] * b.m_data[j];
+            x.m_data[i] = sum;
+        }
+        return x;
+    }
+
+    /* X -= (X u)(v^T X) / (1 + v^T X u) */
+    void maintained_inverse::rank_one (const vector& u, const vector& v) {
+        long unsigned int n = m_a.m_width;
+        if (length (u) != n || length (v) != n)
+            throw std::length_error ("Matrix's sizes are different ");
+        const double* X = m_inverse.m_data;
+        std::vector<double> xu (n, 0.), vx (n, 0.);
+        for (long unsigned int i = 0; i < n; i++)
+            for (long unsigned int j = 0; j < n; j++) {
+                xu[i] += X[i * n + j] * u.m_data[j];
+                vx[j] += v.m_data[i] * X[i * n + j];
+            }
+        double denominator = 1.;
+        for (long unsigned int i = 0; i < n; i++)
+            denominator += v.m_data[i] * xu[i];
+        // порог относительно слагаемых: 1 + v^T X u теряет разряды при сокращении
+        if (std::fabs (denominator) < 1e-10 * (1. + std::fabs (denominator - 1.)))
+            throw singular_error();
+
+        matrix A (m_a), inverse (m_inverse);
+        gemm_add (A.m_data, u.m_data, v.m_data, n, 1, n, 1.);
+        gemm_add (inverse.m_data, xu.data(), vx.data(), n, 1, n, -1. / denominator);
+        commit (A, inverse);
+    }
+
+    /* X -= X U (I + V X U)^-1 V X, система k x k решается LU */
+    void maintained_inverse::update (const matrix& U, const matrix& V) {
+        long unsigned int n = m_a.m_width, k = U.m_width;
+        if (U.m_height != n || V.m_width != n)
+            throw std::length_error ("Matrix's sizes are different ");
+        if (V.m_height != k)
+            throw std::length_error ("Matrixs are not isomeric ");
+        std::vector<double> XU (n * k, 0.), VX (k * n, 0.), S (k * k, 0.);
+        gemm_add (XU.data(), m_inverse.m_data, U.m_data, n, n, k, 1.);
+        gemm_add (VX.data(), V.m_data, m_inverse.m_data, k, n, n, 1.);
+        gemm_add (S.data(), V.m_data, XU.data(), k, n, k, 1.);
+        double scale = 0.;
+        for (long unsigned int i = 0; i < k * k; i++)
+            scale = std::max (scale, std::fabs (S[i]));
+        for (long unsigned int i = 0; i < k; i++)
+            S[i * k + i] += 1.;
+        // VX <- S^-1 V X, S <- LU
+        linear::solve (view (S.data(), k, k, k), view (VX.data(), n, k, n));
+        // порог rank_one для ведущих элементов: при k = 1 это тот же знаменатель
+        for (long unsigned int i = 0; i < k; i++)
+            if (std::fabs (S[i * k + i]) < 1e-10 * (1. + scale))
+                throw singular_error();
+
+        matrix A (m_a), inverse (m_inverse);
+        gemm_add (A.m_data, U.m_data, V.m_data, n, k, n, 1.);
+        gemm_add (inverse.m_data, XU.data(), VX.data(), n, k, n, -1.);
+        commit (A, inverse);
+    }
+
+    void maintained_inverse::set_row (long unsigned int row, const vector& V) {
+        long unsigned int n = m_a.m_width;
+        if (row >= n)
+            throw std::out_of_range ("Index is out of range ");
+        if (length (V) != n)
+            throw std::length_error ("Matrix's sizes are different ");
+        vector u (n, 0.), delta (n);
+        u[row] = 1.;
+        for (long unsigned int j = 0; j < n; j++)
+            delta[j] = V.m_data[j] - m_a.m_data[row * n + j];
+        rank_one (u, delta);
+    }
+
+    void maintained_inverse::set_col (long unsigned int col, const vector& V) {
+        long unsigned int n = m_a.m_width;
+        if (col >= n)
+            throw std::out_of_range ("Index is out of range ");
+        if (length (V) != n)
+            throw std::length_error ("Matrix's sizes are different ");
+        vector v (n, 0.), delta (n);
+        v[col] = 1.;
+        for (long unsigned int i = 0; i < n; i++)
+            delta[i] = V.m_data[i] - m_a.m_data[i * n + col];
+        rank_one (delta, v);
+    }
+
+    void maintained_inverse::refactor() {
+        invert (m_a, m_inverse);
+        m_count = 0;
+    }
+
+
+    // разложение Холецкого
+    maintained_cholesky::maintained_cholesky (const matrix& G, long unsigned int period)
+    : m_gram (G), m_factor (G.get_width(), G.get_height()), m_period (period), m_count (0) {
+        if (G.get_width() != G.get_height())
+            throw std::length_error ("Matrix is not square ");
+        refactor();
+    }
+
+    // разложение во временную матрицу: при потере определённости L не меняется
+    void maintained_cholesky::factor (const matrix& G, matrix& L) {
+        long unsigned int n = G.m_width;
+        const double* g = G.m_data;
+        matrix F (n, n, 0.);
+        double* f = F.m_data;
+        for (long unsigned int j = 0; j < n; j++) {
+            double sum = g[j * n + j];
+            for (long unsigned int k = 0; k < j; k++)
+                sum -= f[j * n + k] * f[j * n + k];
+            if (sum <= 0.)
+                throw std::invalid_argument ("Matrix is not positive definite ");
+            f[j * n + j] = std::sqrt (sum);
+            for (long unsigned int i = j + 1; i < n; i++) {
+                double value = g[i * n + j];
+                for (long unsigned int k = 0; k < j; k++)
+                    value -= f[i * n + k] * f[j * n + k];
+                f[i * n + j] = value / f[j * n + j];
+            }
+        }
+        L = std::move (F);
+    }
+
+    // как maintained_inverse::commit
+    void maintained_cholesky::commit (matrix& G, matrix& L) {
+        bool due = m_period > 0 && m_count + 1 >= m_period;
+        if (due)
+            factor (G, L);
+        m_gram = std::move (G);
+        m_factor = std::move (L);
+        m_count = due? 0: m_count + 1;
+    }
+
+    const matrix& maintained_cholesky::get_matrix() const {
+        return m_gram;
+    }
+
+    triangular maintained_cholesky::get_factor() const {
+        return triangular (m_factor, false);
+    }
+
+    long unsigned int maintained_cholesky::get_count() const {
+        return m_count;
+    }
+
+    /* L y = b, затем L^T x = y */
+    vector maintained_cholesky::solve (const vector& b) const {
+        long unsigned int n = m_gram.m_width;
+        if (length (b) != n)
+            throw std::length_error ("Matrixs are not isomeric ");
+        const double* L = m_factor.m_data;
+        vector x (b);
+        x.touch();
+        double* y = x.m_data;
+        for (long unsigned int i = 0; i < n; i++) {
+            double sum = y[i];
+            for (long unsigned int k = 0; k < i; k++)
+                sum -= L[i * n + k] * y[k];
+            y[i] = sum / L[i * n + i];
+        }
+        for (long unsigned int step = 0; step < n; step++) {
+            long unsigned int i = n - 1 - step;
+            double sum = y[i];
+            for (long unsigned int k = i + 1; k < n; k++)
+                sum -= L[k * n + i] * y[k];
+            y[i] = sum / L[i * n + i];
+        }
+        return x;
+    }
+
+    /* вращения по столбцам L; x портится, поэтому копия */
+    void maintained_cholesky::update (const vector& X) {
+        long unsigned int n = m_gram.m_width;
+        if (length (X) != n)
+            throw std::length_error ("Matrix's sizes are different ");
+        std::vector<double> x (X.m_data, X.m_data + n);
+        matrix G (m_gram), F (m_factor);
+        double* L = F.m_data;
+        for (long unsigned int k = 0; k < n; k++) {
+            double diagonal = L[k * n + k];
+            double r = std::hypot (diagonal, x[k]);
+            double c = r / diagonal, s = x[k] / diagonal;
+            L[k * n + k] = r;
+            for (long unsigned int i = k + 1; i < n; i++) {
+                L[i * n + k] = (L[i * n + k] + s * x[i]) / c;
+                x[i] = c * x[i] - s * L[i * n + k];
+            }
+        }
+        gemm_add (G.m_data, X.m_data, X.m_data, n, 1, n, 1.);
+        commit (G, F);
+    }
+
+    /* гиперболические вращения на копии: при потере определённости L не меняется */
+    void maintained_cholesky::downdate (const vector& X) {
+        long unsigned int n = m_gram.m_width;
+        if (length (X) != n)
+            throw std::length_error ("Matrix's sizes are different ");
+        std::vector<double> x (X.m_data, X.m_data + n);
+        matrix G (m_gram), F (m_factor);
+        double* L = F.m_data;
+        for (long unsigned int k = 0; k < n; k++) {
+            double diagonal = L[k * n + k];
+            double square = (diagonal - x[k]) * (diagonal + x[k]);
+            if (square <= 0.)
+                throw std::invalid_argument ("Matrix is not positive definite ");
+            double r = std::sqrt (square);
+            double c = r / diagonal, s = x[k] / diagonal;
+            L[k * n + k] = r;
+            for (long unsigned int i = k + 1; i < n; i++) {
+                L[i * n + k] = (L[i * n + k] - s * x[i]) / c;
+                x[i] = c * x[i] - s * L[i * n + k];
+            }
+        }
+        gemm_add (G.m_data, X.m_data, X.m_data, n, 1, n, -1.);
+        commit (G, F);
+    }
+
+    void maintained_cholesky::refactor() {
+        factor (m_gram, m_factor);
+        m_count = 0;
+    }
+}
+
+
+#endif /* INCREMENTAL_CPP */
@@ -0,0 +1,100 @@
+#ifndef INCREMENTAL_HPP
+#define INCREMENTAL_HPP
+
+
+#include "matrix.hpp"
+#include "vector.hpp"
+#include "structured.hpp"
+
+
+namespace linear {
+    /* поддержание величин при малоранговых изменениях вместо пересчёта.
+       period - число обновлений до полного пересчёта, ограничивающего
+       накопление ошибки округления; 0 - только по refactor() */
+
+    // C = A B; обновление ранга k стоит O(n^2 k) вместо O(n^3)
+    class maintained_product {
+        private:
+            matrix m_a;
+            matrix m_b;
+            matrix m_c;
+            long unsigned int m_period;
+            long unsigned int m_count;
+
+            void tick();
+
+        public:
+            maintained_product (const matrix& A, const matrix& B, long unsigned int period = 64);
+
+            // вспомогательные
+            const matrix& get_left() const;
+            const matrix& get_right() const;
+            const matrix& get_product() const;
+            long unsigned int get_count() const; // обновлений после пересчёта
+            double drift() const; // max |C - A B|, полный пересчёт для контроля
+
+            // изменения
+            void set_row (long unsigned int row, const vector&);    // строка A
+            void set_col (long unsigned int col, const vector&);    // столбец A
+            void update_left (const matrix& U, const matrix& V);    // A += U V
+            void update_right (const matrix& U, const matrix& V);   // B += U V
+            void refactor();
+    };
+
+    // A^-1 по формулам Шермана-Моррисона-Вудбери
+    class maintained_inverse {
+        private:
+            matrix m_a;
+            matrix m_inverse;
+            long unsigned int m_period;
+            long unsigned int m_count;
+
+            static void invert (const matrix& A, matrix& inverse);
+            void commit (matrix& A, matrix& inverse);
+
+        public:
+            explicit maintained_inverse (const matrix& A, long unsigned int period = 64);
+
+            // вспомогательные
+            const matrix& get_matrix() const;
+            const matrix& get_inverse() const;
+            long unsigned int get_count() const;
+            vector solve (const vector& b) const; // A^-1 b той же ориентации
+
+            // изменения; при вырождении бросают исключение, состояние не меняется
+            void rank_one (const vector& u, const vector& v);     // A += u v^T
+            void update (const matrix& U, const matrix& V);       // A += U V
+            void set_row (long unsigned int row, const vector&);
+            void set_col (long unsigned int col, const vector&);
+            void refactor();
+    };
+
+    // G = L L^T с обновлением и понижением ранга 1 за O(n^2)
+    class maintained_cholesky {
+        private:
+            matrix m_gram;
+            matrix m_factor; // нижний треугольник, верхний - нули
+            long unsigned int m_period;
+            long unsigned int m_count;
+
+            static void factor (const matrix& G, matrix& L);
+            void commit (matrix& G, matrix& L);
+
+        public:
+            explicit maintained_cholesky (const matrix& G, long unsigned int period = 64);
+
+            // вспомогательные
+            const matrix& get_matrix() const;
+            triangular get_factor() const;
+            long unsigned int get_count() const;
+            vector solve (const vector& b) const;
+
+            // изменения; при потере определённости состояние не меняется
+            void update (const vector& x);   // G += x x^T
+            void downdate (const vector& x); // G -= x x^T, G должна остаться положительно определённой
+            void refactor();
+    };
+}
+
+
+#endif /* INCREMENTAL_HPP */
@@ -0,0 +1,74 @@
+#ifndef LINEAR_H
+#define LINEAR_H
+
+
+/* C ABI библиотеки: указатели передаются в ядра без копирования.
+   Матрицы хранятся по строкам, stride - расстояние между строками в
+   элементах. Функции не бросают исключений: результат - код linear_status,
+   текст последней ошибки потока - linear_error() */
+
+#include <stddef.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef enum {
+    LINEAR_OK = 0,
+    LINEAR_INVALID = 1,  /* неверный аргумент */
+    LINEAR_SIZE = 2,     /* несогласованные размеры */
+    LINEAR_SINGULAR = 3, /* вырожденная система */
+    LINEAR_MEMORY = 4,   /* нехватка памяти */
+    LINEAR_FAILURE = 5   /* прочие ошибки */
+} linear_status;
+
+/* непрозрачная матрица библиотеки */
+typedef struct linear_matrix linear_matrix;
+
+/* освобождение внешнего буфера; context передаётся как есть */
+typedef void (*linear_deleter) (double* data, void* context);
+
+/* матрица width x height в собственной памяти, без инициализации */
+linear_matrix* linear_create (size_t width, size_t height);
+
+/* матрица над буфером вызывающего; release == NULL - без владения,
+   иначе release (data, context) вызывается при уничтожении */
+linear_matrix* linear_wrap (double* data, size_t width, size_t height,
+                            linear_deleter release, void* context);
+
+void linear_destroy (linear_matrix* matrix);
+
+double* linear_data (linear_matrix* matrix);
+size_t linear_width (const linear_matrix* matrix);
+size_t linear_height (const linear_matrix* matrix);
+
+/* C = A B для матриц библиотеки; C заранее нужного размера.
+   Память C не должна пересекаться с A и B, в том числе у разных
+   матриц над одним буфером: иначе LINEAR_INVALID */
+linear_status linear_multiply (const linear_matrix* a, const linear_matrix* b, linear_matrix* c);
+
+/* C = A B: A - rows x inner, B - inner x cols, C - rows x cols.
+   Диапазон c не должен пересекаться с a и b: иначе LINEAR_INVALID */
+linear_status linear_gemm (size_t rows, size_t inner, size_t cols,
+                           const double* a, size_t lda, const double* b, size_t ldb,
+                           double* c, size_t ldc);
+
+/* C = A + B, все rows x cols; C может совпадать с A или B целиком
+   (тот же указатель и stride), частичное пересечение - LINEAR_INVALID */
+linear_status linear_add (size_t rows, size_t cols,
+                          const double* a, size_t lda, const double* b, size_t ldb,
+                          double* c, size_t ldc);
+
+/* A X = B на месте: A (n x n) заменяется множителями LU, B (n x cols) - решением.
+   a и b не должны пересекаться: иначе LINEAR_INVALID */
+linear_status linear_solve (size_t n, size_t cols, double* a, size_t lda, double* b, size_t ldb);
+
+const char* linear_error (void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+
+#endif /* LINEAR_H */
@@ -1,8 +1,30 @@
 #include "matrix.hpp"
 #include "vector.hpp"
+#include "profile.hpp"
+#include "quantized.hpp"
+#include "external.hpp"
+#include "parallel.hpp"
+#include "structured.hpp"
+#include "batch.hpp"
+#include "reduce.hpp"
+#include "solver.hpp"
+#include "chain.hpp"
+#include "elementwise.hpp"
+#include "linear.h"
+#include "incremental.hpp"
+#include "gram.hpp"
+#include "stencil.hpp"
 #include <iostream>
 #include <iomanip>
 #include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <cmath>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <sstream>
 
 
 void sep() {
@@ -11,7 +33,999 @@ void sep() {
 
 using namespace linear;
 
-int main() {
+/* профилирование ядер: --profile [размер] */
+void run_profile (long unsigned int n) {
+    profile::counters probe;
+    if (!probe.available())
+        std::cout << "hardware counters unavailable: " << probe.reason() << std::endl;
+
+    matrix A (n, 1.5);
+    matrix B (n, 0.5);
+    double cells = double (n) * n;
+
+    profile::sample S = profile::measure (probe, [&A, &B] { A *= B; });
+    profile::report (std::cout, "operator*=", S, 2. * cells * n, 3. * cells * sizeof (double));
+
+    S = profile::measure (probe, [&A] { A.to_transpose(); });
+    profile::report (std::cout, "to_transpose", S, 0., 2. * cells * sizeof (double));
+
+    S = profile::measure (probe, [&A, &B] { A += B; });
+    profile::report (std::cout, "operator+=", S, cells, 3. * cells * sizeof (double));
+}
+
+/* точность и скорость int8 / bfloat16 против double: --quantized [размер] */
+void run_quantized (long unsigned int n) {
+    matrix A (n, n), B (n, n);
+    matrix_view a = view (A), b = view (B);
+    std::srand (1);
+    for (long unsigned int i = 0; i < n; i++)
+        for (long unsigned int j = 0; j < n; j++) {
+            a (i, j) = double (std::rand()) / RAND_MAX * 2. - 1.;
+            b (i, j) = double (std::rand()) / RAND_MAX * 2. - 1.;
+        }
+
+    auto seconds = [] (std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count();
+    };
+    // относительная ошибка по максимуму модуля
+    auto error = [n] (const matrix& exact, const matrix& approx) {
+        matrix difference = exact - approx;
+        double scale = std::max (std::fabs (exact.max()), std::fabs (exact.min()));
+        return std::max (std::fabs (difference.max()), std::fabs (difference.min())) / scale;
+    };
+    double flops = 2. * n * n * n;
+
+    auto start = std::chrono::steady_clock::now();
+    matrix exact = matrix (A) *= B;
+    double time = seconds (start);
+    std::cout << std::setw (10) << "double" << std::setw (12) << time * 1e3 << " ms "
+              << std::setw (10) << flops / time * 1e-9 << " GFLOP/s "
+              << std::setw (10) << 2 * n * n * sizeof (double) << " B" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    quantized qa (A, per_row), qb (B, per_column);
+    double prepare = seconds (start);
+    start = std::chrono::steady_clock::now();
+    matrix approx = qa * qb;
+    time = seconds (start);
+#if defined (__AVX512F__) && defined (__AVX512VNNI__)
+    const char* int8_path = "int8 vnni";
+#else  /* AVX512VNNI */
+    const char* int8_path = "int8";
+#endif /* AVX512VNNI */
+    std::cout << std::setw (10) << int8_path << std::setw (12) << time * 1e3 << " ms "
+              << std::setw (10) << flops / time * 1e-9 << " GFLOP/s "
+              << std::setw (10) << qa.get_bytes() + qb.get_bytes() << " B"
+              << "  error " << error (exact, approx)
+              << "  quantize " << prepare * 1e3 << " ms" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    bfloat16 ha (A, per_row), hb (B, per_column);
+    prepare = seconds (start);
+    start = std::chrono::steady_clock::now();
+    approx = ha * hb;
+    time = seconds (start);
+#if defined (__AVX512F__) && defined (__AVX512BF16__)
+    const char* bf16_path = "bf16 avx512";
+#else  /* AVX512BF16 */
+    const char* bf16_path = "bf16";
+#endif /* AVX512BF16 */
+    std::cout << std::setw (10) << bf16_path << std::setw (12) << time * 1e3 << " ms "
+              << std::setw (10) << flops / time * 1e-9 << " GFLOP/s "
+              << std::setw (10) << ha.get_bytes() + hb.get_bytes() << " B"
+              << "  error " << error (exact, approx)
+              << "  convert " << prepare * 1e3 << " ms" << std::endl;
+}
+
+/* самопроверка против эталонов: --check [потоков].
+   Каждая проверка идёт на одном потоке и на заданном числе потоков -
+   на одноядерной машине параллельные пути иначе не исполняются */
+static long unsigned int failures = 0;
+
+void check (const char* name, bool passed, double error = 0.) {
+    std::cout << "  " << std::setw (46) << std::left << name << std::right
+              << (passed? "ok  ": "FAIL") << "  " << error << std::endl;
+    if (!passed)
+        failures++;
+}
+
+// матрица width x height со значениями из [-1, 1], воспроизводимо по seed
+matrix random_matrix (long unsigned int width, long unsigned int height, unsigned int seed) {
+    matrix result (width, height);
+    matrix_view data = view (result);
+    std::srand (seed);
+    for (long unsigned int i = 0; i < height; i++)
+        for (long unsigned int j = 0; j < width; j++)
+            data (i, j) = double (std::rand()) / RAND_MAX * 2. - 1.;
+    return result;
+}
+
+// эталон: тройной цикл без блоков и потоков
+matrix reference_product (const matrix& A, const matrix& B) {
+    matrix_view a = view (const_cast<matrix&> (A)), b = view (const_cast<matrix&> (B));
+    matrix result (B.get_width(), A.get_height());
+    matrix_view c = view (result);
+    for (long unsigned int i = 0; i < A.get_height(); i++)
+        for (long unsigned int j = 0; j < B.get_width(); j++) {
+            double sum = 0.;
+            for (long unsigned int k = 0; k < A.get_width(); k++)
+                sum += a (i, k) * b (k, j);
+            c (i, j) = sum;
+        }
+    return result;
+}
+
+// max |A - B| / max(1, max |B|)
+double difference (const matrix& A, const matrix& B) {
+    if (A.get_width() != B.get_width() || A.get_height() != B.get_height())
+        return INFINITY;
+    matrix_view a = view (const_cast<matrix&> (A)), b = view (const_cast<matrix&> (B));
+    double error = 0., scale = 1.;
+    for (long unsigned int i = 0; i < A.get_height(); i++)
+        for (long unsigned int j = 0; j < A.get_width(); j++) {
+            error = std::max (error, std::fabs (a (i, j) - b (i, j)));
+            scale = std::max (scale, std::fabs (b (i, j)));
+        }
+    return error / scale;
+}
+
+/* разбиение for_range, постоянные исполнители и построчные ядра */
+void check_parallel() {
+    bool covered = true;
+    for (long unsigned int count : {1UL, 7UL, 1000UL, 100003UL}) {
+        std::vector<std::atomic<int>> hits (count);
+        parallel::for_range (count, 1UL << 10, [&hits] (long unsigned int begin, long unsigned int end) {
+            for (long unsigned int i = begin; i < end; i++)
+                hits[i]++;
+        });
+        for (auto &hit : hits)
+            covered = covered && (hit == 1);
+    }
+    check ("for_range covers rows once", covered);
+
+    // исполнители постоянные: блок попадает к тому же потоку
+    const long unsigned int count = 1000;
+    std::vector<std::thread::id> first (count), second (count);
+    for (auto owner : {&first, &second})
+        parallel::for_range (count, 1UL << 10, [owner] (long unsigned int begin, long unsigned int) {
+            (*owner)[begin] = std::this_thread::get_id();
+        });
+    bool caller = false;
+    for (auto &id : first)
+        caller = caller || (id == std::this_thread::get_id());
+    check ("for_range reuses pinned workers", first == second && (parallel::get_workers() < 2 || !caller));
+
+    std::atomic<long unsigned int> inner (0);
+    parallel::for_range (64, 1UL << 15, [&inner] (long unsigned int begin, long unsigned int end) {
+        for (long unsigned int i = begin; i < end; i++)
+            parallel::for_range (64, 1UL << 15, [&inner] (long unsigned int from, long unsigned int to) {
+                inner += to - from;
+            });
+    });
+    check ("nested for_range runs serially", inner == 64 * 64);
+
+    bool thrown = false;
+    try {
+        parallel::for_range (count, 1UL << 10, [] (long unsigned int begin, long unsigned int) {
+            if (begin > 0)
+                throw std::out_of_range ("Index is out of range ");
+        });
+    } catch (std::out_of_range&) {
+        thrown = true;
+    }
+    check ("for_range rethrows body exception", thrown || parallel::get_workers() < 2);
+
+    matrix A = random_matrix (150, 130, 1), B = random_matrix (170, 150, 2);
+    double error = difference (matrix (A) *= B, reference_product (A, B));
+    check ("operator*= vs triple loop", error < 1e-12, error);
+
+    matrix C = random_matrix (300, 200, 3), D = random_matrix (300, 200, 4);
+    matrix sum = C + D, expected (300UL, 200UL);
+    matrix_view c = view (C), d = view (D), e = view (expected);
+    for (long unsigned int i = 0; i < 200; i++)
+        for (long unsigned int j = 0; j < 300; j++)
+            e (i, j) = c (i, j) + d (i, j);
+    error = difference (sum, expected);
+    check ("operator+ vs loop", error == 0., error);
+
+    matrix filled (300UL, 300UL, 2.5);
+    check ("def constructor first touch", filled.min() == 2.5 && filled.max() == 2.5);
+}
+
+/* замер и единицы крыши в report */
+void check_profile() {
+    profile::counters probe;
+    matrix A = random_matrix (64, 64, 5);
+    profile::sample S = profile::measure (probe, [&A] { A.to_transpose(); });
+    check ("measure returns wall time", S.seconds > 0.);
+
+    // синтетический замер: 4 потока по 3 ГГц в течение секунды
+    const profile::roofline& roof = profile::roofline::host();
+    profile::sample fake;
+    fake.seconds = 1.;
+    for (int e = 0; e < profile::events; e++) {
+        fake.count[e] = 0;
+        fake.valid[e] = false;
+    }
+    fake.count[profile::cycles] = 4 * 3000000000UL;
+    fake.valid[profile::cycles] = true;
+    double core_cycles = double (fake.count[profile::cycles]);
+
+    std::ostringstream compute, memory;
+    profile::report (compute, "compute", fake, 0.5 * roof.flops_per_cycle * core_cycles, 1.);
+    profile::report (memory, "memory", fake, 1e6, 1e6 * roof.bandwidth);
+    check ("report: half of core peak is compute bound", compute.str().find ("compute bound") != std::string::npos);
+    check ("report: intensity 1e-6 is memory bound", memory.str().find ("memory bound") != std::string::npos);
+}
+
+/* структурированные матрицы против плотных */
+void check_structured() {
+    const long unsigned int n = 40;
+    matrix dense = random_matrix (n, n, 6), other = random_matrix (n, n, 7);
+    diagonal D (dense);
+    triangular T (dense, false);
+    symmetric S (dense);
+    banded B (dense, 2, 3);
+
+    vector column = {1, 2, 3};
+    column.to_transpose();
+    diagonal from_column (column);
+    check ("diagonal from column vector", from_column.get_size() == 3 && from_column[2] == 3.);
+
+    double worst = 0.;
+    auto compare = [&worst] (const matrix& structured, const matrix& expected) {
+        worst = std::max (worst, difference (structured, expected));
+    };
+    auto interop = [&] (auto& X) {
+        matrix full = X.get_matrix();
+        compare (X * other, reference_product (full, other));
+        compare (other * X, reference_product (other, full));
+        compare (other + X, other + full);
+        compare (other - X, other - full);
+        compare (X - other, full - other);
+        matrix inplace (other);
+        inplace += X;
+        compare (inplace, other + full);
+        inplace -= X;
+        inplace -= X;
+        compare (inplace, other - full);
+    };
+    interop (D);
+    interop (T);
+    interop (S);
+    interop (B);
+    check ("* + - += -= vs dense", worst < 1e-12, worst);
+
+    // T x = b и B x = b: невязка через плотное произведение
+    vector b (n, 1.);
+    b.to_transpose();
+    for (long unsigned int i = 0; i < n; i++)
+        T.at (i, i) += 4.;
+    for (long unsigned int i = 0; i < n; i++)
+        B.at (i, i) += 8.;
+    double residual = std::max (difference (T * T.solve (b), b), difference (B * B.solve (b), b));
+    check ("triangular/banded solve residual", residual < 1e-12, residual);
+
+    // нулевая и малая диагональ требуют перестановок строк
+    banded swap (2, 1, 1);
+    swap.at (0, 1) = swap.at (1, 0) = 1.;
+    vector rhs {1., 2.};
+    rhs.to_transpose();
+    vector x = swap.solve (rhs);
+    const double* value = view (x).get_data();
+    check ("banded solve [[0,1],[1,0]]", value[0] == 2. && value[1] == 1.);
+    banded skewed (n, 2, 1);
+    matrix_view source = view (dense);
+    for (long unsigned int i = 0; i < n; i++)
+        for (long unsigned int j = (i > 2)? i - 2: 0; j < n && j <= i + 1; j++)
+            skewed.at (i, j) = (i == j)? 1e-14 * source (i, j): source (i, j);
+    residual = difference (skewed * skewed.solve (b), b);
+    check ("banded solve with tiny diagonal", residual < 1e-10, residual);
+}
+
+/* пакетные ядра против скалярных vect_mul / scal_mul / sin / angle */
+void check_batch() {
+    const long unsigned int n = 5000;
+    matrix source = random_matrix (6, n, 8);
+    matrix_view data = view (source);
+    batch A (n), B (n);
+    for (long unsigned int i = 0; i < n; i++) {
+        A.set (i, vector {data (i, 0), data (i, 1), data (i, 2)});
+        B.set (i, vector {data (i, 3), data (i, 4), data (i, 5)});
+    }
+    batch C = vect_mul (A, B);
+    vector dot = scal_mul (A, B), sines = sin (A, B), angles = angle (A, B);
+    double worst = 0.;
+    for (long unsigned int i = 0; i < n; i++) {
+        vector a = A.get (i), b = B.get (i);
+        worst = std::max (worst, difference (C.get (i), vect_mul (a, b)));
+        worst = std::max (worst, std::fabs (dot[i] - scal_mul (a, b)));
+        worst = std::max (worst, std::fabs (sines[i] - sin (a, b)));
+        worst = std::max (worst, std::fabs (angles[i] - angle (a, b)) / 180.);
+    }
+    check ("batch vs scalar kernels", worst < 1e-12, worst);
+
+    vector column = {1, 2, 3};
+    column.to_transpose();
+    A.set (0, column);
+    batch filled (3, column);
+    check ("set / fill from column 3-vector", difference (A.get (0), vector {1, 2, 3}) == 0.
+                                               && difference (filled.get (2), vector {1, 2, 3}) == 0.);
+
+    bool invalid = false;
+    try {
+        sin (column, column);
+    } catch (std::invalid_argument&) {
+        invalid = true;
+    } catch (std::exception&) {}
+    check ("sin of column vectors: invalid_argument", invalid);
+}
+
+/* воспроизводимая свёртка побитово одинакова при любом числе потоков */
+void check_reduce() {
+    const long unsigned int n = 1000003;
+    matrix a = random_matrix (n, 1, 9), b = random_matrix (n, 1, 10);
+    const double* x = view (a).get_data();
+    const double* y = view (b).get_data();
+    long double exact = 0.;
+    for (long unsigned int i = 0; i < n; i++)
+        exact += (long double) x[i] * y[i];
+
+    reduction::mode saved = reduction::get_mode();
+    long unsigned int workers = parallel::get_workers();
+    reduction::set_mode (reduction::reproducible);
+    double first = 0.;
+    bool identical = true;
+    for (long unsigned int count : {1UL, 2UL, 3UL, 5UL}) {
+        parallel::set_workers (count);
+        double value = reduction::dot (x, y, n);
+        if (count == 1)
+            first = value;
+        identical = identical && (value == first);
+    }
+    check ("reproducible dot: 1/2/3/5 workers identical", identical);
+    check ("reproducible dot vs long double", std::fabs (first - exact) < 1e-10, double (std::fabs (first - exact)));
+
+    parallel::set_workers (workers);
+    reduction::set_mode (reduction::fast);
+    double fast = reduction::dot (x, y, n);
+    check ("fast dot vs long double", std::fabs (fast - exact) < 1e-10, double (std::fabs (fast - exact)));
+    reduction::set_mode (saved);
+}
+
+/* итерационные решатели, невязка пересчитывается плотно */
+void check_solver() {
+    const long unsigned int n = 200;
+    banded symmetric_band (n, 1, 1), skew_band (n, 1, 1);
+    for (long unsigned int i = 0; i < n; i++) {
+        symmetric_band.at (i, i) = skew_band.at (i, i) = 2.5;
+        if (i > 0) {
+            symmetric_band.at (i, i - 1) = -1.;
+            skew_band.at (i, i - 1) = -1.3;
+        }
+        if (i + 1 < n) {
+            symmetric_band.at (i, i + 1) = -1.;
+            skew_band.at (i, i + 1) = -0.7;
+        }
+    }
+    matrix spd = symmetric_band.get_matrix(), general = skew_band.get_matrix();
+    sparse A (spd), G (general);
+    vector b (n, 1.);
+    const double tolerance = 1e-10;
+
+    // |b - A x| / |b| по плотной матрице
+    auto residual = [&b] (const matrix& M, const vector& x) {
+        matrix_view m = view (const_cast<matrix&> (M));
+        double r = 0., norm = 0.;
+        for (long unsigned int i = 0; i < b.get_width(); i++) {
+            double sum = b[i];
+            for (long unsigned int j = 0; j < b.get_width(); j++)
+                sum -= m (i, j) * x[j];
+            r += sum * sum;
+            norm += b[i] * b[i];
+        }
+        return std::sqrt (r / norm);
+    };
+    auto verify = [&] (const char* name, const solve_info& info, const matrix& M, const vector& x) {
+        double r = residual (M, x);
+        check (name, info.converged && r <= tolerance && std::fabs (r - info.residual) < 1e-12, r);
+    };
+
+    vector x (n, 0.);
+    verify ("cg + ilu0", cg (A, b, x, ilu0 (A), tolerance), spd, x);
+    x = vector (n, 0.);
+    verify ("gmres + jacobi", gmres (G, b, x, jacobi (G), tolerance), general, x);
+    x = vector (n, 0.);
+    verify ("bicgstab", bicgstab (G, b, x, tolerance), general, x);
+
+    // недостаточно итераций: converged обязан быть false во всех трёх
+    x = vector (n, 0.);
+    bool cg_short = cg (A, b, x, tolerance, 3).converged;
+    x = vector (n, 0.);
+    bool gmres_short = gmres (G, b, x, tolerance, 3).converged;
+    x = vector (n, 0.);
+    bool bicgstab_short = bicgstab (G, b, x, tolerance, 3).converged;
+    check ("3 iterations: not converged", !cg_short && !gmres_short && !bicgstab_short);
+}
+
+/* цепочка произведений против умножения по порядку */
+void check_chain() {
+    matrix A = random_matrix (40, 10, 11), B = random_matrix (5, 40, 12);
+    matrix C = random_matrix (30, 5, 13), D = random_matrix (30, 20, 14);
+    matrix expected = reference_product (reference_product (reference_product (A, B), C), D.get_transpose());
+
+    chain plan {A, B, C, transposed (D)};
+    check ("chain: cost not above naive", plan.get_cost() <= plan.get_naive_cost(), plan.get_cost());
+    double error = difference (plan.evaluate(), expected);
+    check ("chain::evaluate A B C D^T", error < 1e-12, error);
+    error = difference (multiply ({A, B, C, transposed (D)}), expected);
+    check ("multiply A B C D^T", error < 1e-12, error);
+}
+
+/* поэлементные примитивы против циклов */
+void check_elementwise() {
+    const long unsigned int width = 101, height = 99;
+    matrix A = random_matrix (width, height, 15), B = random_matrix (width, height, 16);
+    const double* a = view (A).get_data();
+    const double* b = view (B).get_data();
+    matrix expected (width, height);
+    double* e = view (expected).get_data();
+
+    for (long unsigned int i = 0; i < width * height; i++)
+        e[i] = std::exp (a[i]);
+    double error = difference (map (A, [] (double x) { return std::exp (x); }), expected);
+    check ("map exp", error < 1e-14, error);
+
+    for (long unsigned int i = 0; i < width * height; i++)
+        e[i] = a[i] * b[i] + double (i);
+    error = difference (zip_with ([] (long unsigned int i, double x, double y) { return x * y + double (i); }, A, B), expected);
+    check ("zip_with with index", error == 0., error);
+
+    matrix C (A);
+    transform (C, [] (double x, double y) { return x - 2. * y; }, B);
+    for (long unsigned int i = 0; i < width * height; i++)
+        e[i] = a[i] - 2. * b[i];
+    error = difference (C, expected);
+    check ("transform in place", error == 0., error);
+
+    // накопитель-структура: сумма и максимум модуля
+    struct summary {
+        double sum;
+        double peak;
+        summary (double x = 0.): sum (x), peak (std::fabs (x)) {}
+    };
+    summary loop;
+    for (long unsigned int i = 0; i < width * height; i++) {
+        loop.sum += a[i] * b[i];
+        loop.peak = std::max (loop.peak, std::fabs (a[i] * b[i]));
+    }
+    summary result = transform_reduce (summary(), [] (summary x, const summary& y) {
+        x.sum += y.sum;
+        x.peak = std::max (x.peak, y.peak);
+        return x;
+    }, [] (double x, double y) { return x * y; }, A, B);
+    error = std::fabs (result.sum - loop.sum);
+    check ("transform_reduce sum", error < 1e-10, error);
+    check ("transform_reduce max |a b|", result.peak == loop.peak);
+
+    // норма с argmax: при равных модулях меньший индекс, reduce коммутативна
+    struct norm_argmax {
+        double squares;
+        double peak;
+        long unsigned int index;
+    };
+    norm_argmax expected_peak = {0., -1., 0};
+    for (long unsigned int i = 0; i < width * height; i++) {
+        expected_peak.squares += a[i] * a[i];
+        if (std::fabs (a[i]) > expected_peak.peak) {
+            expected_peak.peak = std::fabs (a[i]);
+            expected_peak.index = i;
+        }
+    }
+    norm_argmax found = transform_reduce (norm_argmax {0., -1., 0}, [] (norm_argmax x, const norm_argmax& y) {
+        x.squares += y.squares;
+        if (y.peak > x.peak || (y.peak == x.peak && y.index < x.index)) {
+            x.peak = y.peak;
+            x.index = y.index;
+        }
+        return x;
+    }, [] (long unsigned int i, double x) { return norm_argmax {x * x, std::fabs (x), i}; }, A);
+    error = std::fabs (std::sqrt (found.squares) - std::sqrt (expected_peak.squares));
+    check ("transform_reduce norm with argmax", error < 1e-12 && found.index == expected_peak.index, error);
+
+    // обобщённая лямбда получает значения, не индекс
+    error = difference (map (A, [] (auto x) { return x * 2.; }), A * 2.);
+    check ("map with generic lambda", error == 0., error);
+
+    bool thrown = false;
+    try {
+        zip_with ([] (double x, double y) { return x + y; }, A, random_matrix (height, width, 17));
+    } catch (std::length_error&) {
+        thrown = true;
+    }
+    check ("zip_with shape mismatch: length_error", thrown);
+}
+
+/* внешнее, поэлементное, кронекерово произведения и трансляция */
+void check_products() {
+    const long unsigned int width = 37, height = 23;
+    matrix A = random_matrix (width, height, 18), B = random_matrix (width, height, 19);
+    matrix_view a = view (A), b = view (B);
+    vector u (height, 0.), v (width, 0.);
+    double* x = view (u).get_data();
+    double* y = view (v).get_data();
+    for (long unsigned int i = 0; i < height; i++)
+        x[i] = std::sin (double (i));
+    for (long unsigned int j = 0; j < width; j++)
+        y[j] = std::cos (double (j));
+
+    matrix expected (width, height);
+    matrix_view e = view (expected);
+    for (long unsigned int i = 0; i < height; i++)
+        for (long unsigned int j = 0; j < width; j++)
+            e (i, j) = x[i] * y[j];
+    double error = difference (outer (u, v), expected);
+    check ("outer row x row", error == 0., error);
+    vector column (v);
+    column.to_transpose();
+    error = difference (outer (u, column), expected);
+    check ("outer row x column", error == 0., error);
+
+    for (long unsigned int i = 0; i < height; i++)
+        for (long unsigned int j = 0; j < width; j++)
+            e (i, j) = a (i, j) * b (i, j);
+    error = difference (hadamard (A, B), expected);
+    check ("hadamard", error == 0., error);
+    error = difference (matrix (A).to_hadamard (B), expected);
+    check ("to_hadamard", error == 0., error);
+
+    for (long unsigned int i = 0; i < height; i++)
+        for (long unsigned int j = 0; j < width; j++)
+            e (i, j) = a (i, j) + y[j];
+    error = difference (matrix (A).add_to_rows (v), expected);
+    check ("add_to_rows", error == 0., error);
+    for (long unsigned int i = 0; i < height; i++)
+        for (long unsigned int j = 0; j < width; j++)
+            e (i, j) = a (i, j) * x[i];
+    error = difference (matrix (A).mul_to_cols (u), expected);
+    check ("mul_to_cols", error == 0., error);
+
+    matrix P = random_matrix (3, 4, 20), Q = random_matrix (5, 2, 21);
+    matrix_view p = view (P), q = view (Q);
+    matrix product (15UL, 8UL);
+    matrix_view k = view (product);
+    for (long unsigned int i = 0; i < 8; i++)
+        for (long unsigned int j = 0; j < 15; j++)
+            k (i, j) = p (i / 2, j / 5) * q (i % 2, j % 5);
+    error = difference (kronecker (P, Q), product);
+    check ("kronecker", error == 0., error);
+
+    bool thrown = false;
+    try {
+        matrix (A).add_to_rows (u);
+    } catch (std::length_error&) {
+        thrown = true;
+    }
+    check ("add_to_rows length mismatch: length_error", thrown);
+}
+
+/* кэш статистик сбрасывается записью и переносится перемещением */
+void check_cache() {
+    matrix A = random_matrix (64, 48, 22);
+    matrix plain (A);
+    A.set_cache (true);
+    bool equal = A.norm() == plain.norm() && A.sum() == plain.sum()
+              && A.max() == plain.max() && A.min() == plain.min();
+    check ("cached statistics equal uncached", equal);
+
+    A += A;
+    plain += plain;
+    check ("after +=: norm recomputed", A.norm() == plain.norm(), std::fabs (A.norm() - plain.norm()));
+    double sum = A.sum();
+    A.to_transpose();
+    check ("after transpose: sum kept", A.sum() == sum);
+
+    vector v (100, 1.), w (100, 1.);
+    v.set_cache (true);
+    double before = v.sum();
+    v[7] = 3.;
+    check ("after vector::operator[]: sum recomputed", before == 100. && v.sum() == 102.);
+
+    matrix moved (std::move (A));
+    matrix target (2UL, 2UL, 0.);
+    target = std::move (moved);
+    check ("move assignment carries cache flag", target.get_cache() && target.norm() == plain.norm());
+    w = std::move (v);
+    check ("vector move assignment carries cache flag", w.get_cache() && w.sum() == 102.);
+    matrix copy (target);
+    check ("copy starts with cache off", !copy.get_cache());
+}
+
+/* внешняя память и коды C ABI */
+void check_capi() {
+    const long unsigned int n = 40;
+    matrix A = random_matrix (n, n, 23), X = random_matrix (3, n, 24);
+    matrix_view a = view (A);
+    for (long unsigned int i = 0; i < n; i++)
+        a (i, i) += double (n);
+    matrix B = reference_product (A, X), LU (A), solution (B);
+    linear_status status = linear_solve (n, 3, view (LU).get_data(), n, view (solution).get_data(), 3);
+    double error = difference (solution, X);
+    check ("linear_solve: LINEAR_OK and solution", status == LINEAR_OK && error < 1e-12, error);
+
+    // строка 5 повторяет строку 2
+    matrix S (A), rhs (B);
+    matrix_view s = view (S);
+    for (long unsigned int j = 0; j < n; j++)
+        s (5, j) = s (2, j);
+    status = linear_solve (n, 3, view (S).get_data(), n, view (rhs).get_data(), 3);
+    check ("linear_solve singular: LINEAR_SINGULAR", status == LINEAR_SINGULAR);
+
+    bool thrown = false;
+    try {
+        S = A;
+        for (long unsigned int j = 0; j < n; j++)
+            s (5, j) = 0.;
+        solve (view (S), view (rhs));
+    } catch (singular_error&) {
+        thrown = true;
+    }
+    check ("solve singular: singular_error", thrown);
+
+    check ("linear_multiply null: LINEAR_INVALID", linear_multiply (nullptr, nullptr, nullptr) == LINEAR_INVALID);
+    linear_matrix* left = linear_create (3, 4);
+    linear_matrix* right = linear_create (3, 4);
+    linear_matrix* product = linear_create (3, 4);
+    check ("linear_multiply shapes: LINEAR_SIZE", linear_multiply (left, right, product) == LINEAR_SIZE);
+    linear_destroy (left);
+    linear_destroy (right);
+    linear_destroy (product);
+
+    // результаты операций над внешним буфером остаются в нём
+    std::vector<double> storage (6 * 6, 0.);
+    int released = 0;
+    {
+        matrix square = random_matrix (6, 6, 34);
+        matrix outside (storage.data(), 6UL, 6UL, [&released] (double*) { released++; });
+        outside = square;
+        outside *= square;
+        bool kept = view (outside).get_data() == storage.data()
+                 && difference (outside, reference_product (square, square)) < 1e-12;
+        outside = reference_product (square, square.get_transpose());
+        kept = kept && view (outside).get_data() == storage.data() && storage[0] == view (outside)(0, 0);
+        matrix wide = random_matrix (6, 4, 35);
+        matrix borrowed (storage.data(), 6UL, 4UL);
+        borrowed = wide;
+        borrowed.to_transpose();
+        kept = kept && view (borrowed).get_data() == storage.data() && storage[1] == view (wide)(1, 0);
+        check ("external buffer keeps *=, = and transpose", kept && released == 0);
+        bool thrown = false;
+        try {
+            borrowed *= random_matrix (2, 6, 36);
+        } catch (std::length_error&) {
+            thrown = true;
+        }
+        check ("external buffer resize: length_error", thrown && borrowed.get_width() == 4 && released == 0);
+    }
+    check ("external deleter runs once at destruction", released == 1);
+
+    // пересечения по памяти, а не по дескрипторам
+    std::vector<double> memory (5 * 4, 1.);
+    double* buffer = memory.data();
+    check ("linear_gemm c == a: LINEAR_INVALID", linear_gemm (4, 4, 4, buffer, 4, buffer + 16, 0, buffer, 4) == LINEAR_INVALID);
+    linear_matrix* first = linear_wrap (buffer, 4, 4, nullptr, nullptr);
+    linear_matrix* second = linear_wrap (buffer + 4, 4, 4, nullptr, nullptr);
+    check ("linear_multiply shared buffer: LINEAR_INVALID", linear_multiply (first, first, second) == LINEAR_INVALID);
+    linear_destroy (first);
+    linear_destroy (second);
+    std::vector<double> ones (16, 1.);
+    status = linear_add (4, 4, buffer, 4, ones.data(), 4, buffer, 4);
+    check ("linear_add in place: LINEAR_OK", status == LINEAR_OK && buffer[15] == 2. && buffer[16] == 1.);
+    check ("linear_add shifted result: LINEAR_INVALID", linear_add (4, 4, buffer, 4, buffer, 4, buffer + 4, 4) == LINEAR_INVALID);
+}
+
+/* пониженная точность против double; глубина и ширина не кратны упаковке */
+void check_quantized() {
+    matrix A = random_matrix (70, 33, 25), B = random_matrix (29, 70, 26);
+    matrix exact = reference_product (A, B);
+
+    quantized qa (A, per_row), qb (B, per_column);
+    double error = difference (qa * qb, reference_product (qa.dequantize(), qb.dequantize()));
+    check ("int8 vs dequantized product", error < 1e-5, error);
+    error = difference (qa * qb, exact);
+    check ("int8 vs double product", error < 2e-2, error);
+
+    bfloat16 ba (A, per_row), bb (B, per_column);
+    error = difference (ba * bb, reference_product (ba.dequantize(), bb.dequantize()));
+    check ("bf16 vs dequantized product", error < 1e-5, error);
+    error = difference (ba * bb, exact);
+    check ("bf16 vs double product", error < 2e-2, error);
+
+    bool thrown = false;
+    try {
+        quantized (A, per_column) * qb;
+    } catch (std::exception&) {
+        thrown = true;
+    }
+    check ("int8 wrong axes: throws", thrown);
+}
+
+/* поддерживаемые произведение, обратная и Холецкий против пересчёта */
+matrix reference_inverse (const matrix& A) {
+    long unsigned int n = A.get_width();
+    matrix LU (A), X (n, n, 0.);
+    matrix_view x = view (X);
+    for (long unsigned int i = 0; i < n; i++)
+        x (i, i) = 1.;
+    solve (view (LU), view (X));
+    return X;
+}
+
+void check_incremental() {
+    const long unsigned int n = 48, k = 3;
+    matrix A = random_matrix (n, n, 27);
+    matrix_view a = view (A);
+    for (long unsigned int i = 0; i < n; i++)
+        a (i, i) += double (n);
+
+    maintained_inverse inverse (A, 5);
+    matrix U = random_matrix (k, n, 28), V = random_matrix (n, k, 29);
+    inverse.update (U, V);
+    vector u (n, 0.), w (n, 0.);
+    double* p = view (u).get_data();
+    double* q = view (w).get_data();
+    for (long unsigned int i = 0; i < n; i++) {
+        p[i] = std::sin (double (i));
+        q[i] = std::cos (double (3 * i));
+    }
+    inverse.rank_one (u, w);
+    matrix expected = A + reference_product (U, V) + reference_product (u.get_transpose(), w);
+    double error = difference (inverse.get_matrix(), expected);
+    error = std::max (error, difference (inverse.get_inverse(), reference_inverse (expected)));
+    check ("maintained_inverse vs recomputed", error < 1e-12 && inverse.get_count() == 2, error);
+
+    // строки 0 и 1 обнуляются: I + V X U вырождена
+    matrix Z (2UL, n, 0.), W (n, 2UL), current = inverse.get_matrix();
+    matrix_view z = view (Z), e = view (current), m = view (W);
+    z (0, 0) = z (1, 1) = 1.;
+    for (long unsigned int j = 0; j < n; j++) {
+        m (0, j) = -e (0, j);
+        m (1, j) = -e (1, j);
+    }
+    matrix before = inverse.get_inverse();
+    bool thrown = false;
+    try {
+        inverse.update (Z, W);
+    } catch (singular_error&) {
+        thrown = true;
+    }
+    check ("singular rank-2 update: state unchanged", thrown && inverse.get_count() == 2
+           && difference (inverse.get_inverse(), before) == 0. && difference (inverse.get_matrix(), current) == 0.);
+
+    for (long unsigned int step = 0; step < 3; step++)
+        inverse.rank_one (u, w);
+    check ("period reached: refactored", inverse.get_count() == 0);
+
+    matrix G = reference_product (A.get_transpose(), A);
+    maintained_cholesky cholesky (G, 4);
+    cholesky.update (u);
+    cholesky.downdate (w);
+    matrix target = G + reference_product (u.get_transpose(), u) - reference_product (w.get_transpose(), w);
+    matrix factor = cholesky.get_factor().get_matrix();
+    error = difference (reference_product (factor, factor.get_transpose()), target);
+    check ("maintained_cholesky L L^T vs G", error < 1e-12, error);
+
+    thrown = false;
+    before = factor;
+    vector large (n, 1e3);
+    try {
+        cholesky.downdate (large);
+    } catch (std::invalid_argument&) {
+        thrown = true;
+    }
+    check ("indefinite downdate: state unchanged", thrown && cholesky.get_count() == 2
+           && difference (cholesky.get_factor().get_matrix(), before) == 0.);
+
+    maintained_product product (A, G, 0);
+    product.update_left (U, V);
+    product.update_right (reference_product (G, U), V);
+    check ("maintained_product drift", product.drift() < 1e-9, product.drift());
+}
+
+/* матрица Грама и ковариация против двухпроходного эталона */
+void check_gram() {
+    const long unsigned int rows = 5000, dim = 13;
+    matrix A = random_matrix (dim, rows, 30);
+    matrix_view a = view (A);
+    for (long unsigned int i = 0; i < rows; i++)
+        for (long unsigned int j = 0; j < dim; j++)
+            a (i, j) += 100. + double (j);
+
+    double error = difference (gram (A), reference_product (A.get_transpose(), A));
+    check ("gram vs A^T A", error < 1e-12, error);
+
+    // два прохода: среднее, затем центрированное произведение
+    matrix centered (A);
+    matrix_view c = view (centered);
+    for (long unsigned int j = 0; j < dim; j++) {
+        double mean = 0.;
+        for (long unsigned int i = 0; i < rows; i++)
+            mean += a (i, j);
+        mean /= double (rows);
+        for (long unsigned int i = 0; i < rows; i++)
+            c (i, j) -= mean;
+    }
+    matrix expected = reference_product (centered.get_transpose(), centered) * (1. / double (rows - 1));
+    error = difference (covariance (A), expected);
+    check ("covariance vs two-pass", error < 1e-10, error);
+
+    gram_accumulator first (dim, true), second (dim, true);
+    first.add (matrix_view (a.get_data(), dim, 1800, dim).get_matrix());
+    second.add (a.get_data() + 1800 * dim, rows - 1800, dim);
+    first.merge (second);
+    error = difference (first.covariance(), expected);
+    check ("merge of two halves", error < 1e-10 && first.get_count() == rows, error);
+
+    std::stringstream text, binary;
+    text << std::setprecision (17);
+    for (long unsigned int i = 0; i < rows; i++) {
+        for (long unsigned int j = 0; j < dim; j++)
+            text << a (i, j) << " ";
+        text << "\n";
+    }
+    binary.write (reinterpret_cast<const char*> (a.get_data()), rows * dim * sizeof (double));
+    gram_accumulator from_text (dim, true), from_binary (dim, true);
+    long unsigned int count = from_text.read (text);
+    error = difference (from_text.covariance(), expected);
+    check ("read text stream", error < 1e-10 && count == rows, error);
+    count = from_binary.read_binary (binary);
+    error = difference (from_binary.covariance(), expected);
+    check ("read binary stream", error < 1e-10 && count == rows, error);
+}
+
+/* свёртка, банк и итерации против прямого суммирования */
+matrix reference_convolve (const matrix& M, const matrix& weights, border policy) {
+    long unsigned int H = M.get_height(), W = M.get_width();
+    long unsigned int h = weights.get_height(), w = weights.get_width();
+    matrix result (W, H, 0.);
+    matrix_view m = view (const_cast<matrix&> (M)), k = view (const_cast<matrix&> (weights)), r = view (result);
+    for (long int i = 0; i < long (H); i++)
+        for (long int j = 0; j < long (W); j++) {
+            double sum = 0.;
+            for (long int a = 0; a < long (h); a++)
+                for (long int b = 0; b < long (w); b++) {
+                    long int y = i + a - long (h - 1) / 2, x = j + b - long (w - 1) / 2;
+                    if (policy == clamp_border) {
+                        y = std::min (std::max (y, 0L), long (H) - 1);
+                        x = std::min (std::max (x, 0L), long (W) - 1);
+                    } else if (policy == wrap_border) {
+                        y = (y % long (H) + long (H)) % long (H);
+                        x = (x % long (W) + long (W)) % long (W);
+                    } else if (y < 0 || y >= long (H) || x < 0 || x >= long (W))
+                        continue;
+                    sum += k (a, b) * m (y, x);
+                }
+            r (i, j) = sum;
+        }
+    return result;
+}
+
+void check_stencil() {
+    matrix M = random_matrix (90UL, 130UL, 31);
+    matrix weights = random_matrix (3UL, 3UL, 32), small = random_matrix (2UL, 2UL, 33);
+    vector col (5, 0.), row (3, 0.);
+    double* c = view (col).get_data();
+    double* r = view (row).get_data();
+    for (long unsigned int i = 0; i < 5; i++)
+        c[i] = 1. + double (i);
+    for (long unsigned int j = 0; j < 3; j++)
+        r[j] = 0.5 - double (j);
+    stencil separable (col, row);
+
+    const char* names[] = {"zero", "clamp", "wrap"};
+    for (border policy : {zero_border, clamp_border, wrap_border}) {
+        std::string name = std::string ("convolve 3x3 ") + names[policy];
+        double error = difference (convolve (M, stencil (weights), policy), reference_convolve (M, weights, policy));
+        check (name.c_str(), error < 1e-12, error);
+
+        name = std::string ("convolve separable 5x3 ") + names[policy];
+        error = difference (convolve (M, separable, policy), reference_convolve (M, separable.get_weights(), policy));
+        check (name.c_str(), separable.is_separable() && error < 1e-12, error);
+
+        // 20 шагов: несколько временных блоков и неполный последний
+        for (const matrix* K : {&weights, &small}) {
+            matrix expected (M);
+            for (long unsigned int step = 0; step < 20; step++)
+                expected = reference_convolve (expected, *K * 0.2, policy);
+            name = std::string ("iterate 20 steps ") + (K == &small? "2x2 ": "3x3 ") + names[policy];
+            error = difference (iterate (M, stencil (*K * 0.2), 20, policy), expected);
+            check (name.c_str(), error < 1e-12, error);
+        }
+
+        std::vector<stencil> bank;
+        for (unsigned int seed = 40; seed < 45; seed++)
+            bank.push_back (stencil (random_matrix (3UL, 3UL, seed)));
+        std::vector<matrix> outputs = convolve (M, bank, policy);
+        error = 0.;
+        for (long unsigned int i = 0; i < bank.size(); i++)
+            error = std::max (error, difference (outputs[i], reference_convolve (M, bank[i].get_weights(), policy)));
+        name = std::string ("bank of 5 (im2col) ") + names[policy];
+        check (name.c_str(), outputs.size() == bank.size() && error < 1e-12, error);
+    }
+
+    // два внешних буфера над одной памятью со сдвигом на строку
+    std::vector<double> buffer (91 * 130, 1.);
+    matrix operand (buffer.data(), 90UL, 130UL), alias (buffer.data() + 90, 90UL, 130UL);
+    bool thrown = false;
+    try {
+        convolve (operand, stencil (weights), alias);
+    } catch (std::invalid_argument&) {
+        thrown = true;
+    }
+    check ("external result over operand: throws", thrown);
+}
+
+int run_check (long unsigned int workers) {
+    for (long unsigned int count : {1UL, workers}) {
+        parallel::set_workers (count);
+        std::cout << "workers: " << count << std::endl;
+        check_parallel();
+        check_profile();
+        check_structured();
+        check_batch();
+        check_reduce();
+        check_solver();
+        check_chain();
+        check_elementwise();
+        check_products();
+        check_cache();
+        check_capi();
+        check_quantized();
+        check_incremental();
+        check_gram();
+        check_stencil();
+    }
+    parallel::set_workers (0);
+    if (failures == 0)
+        std::cout << "all checks passed" << std::endl;
+    else
+        std::cout << "checks failed: " << failures << std::endl;
+    return (failures == 0)? 0: 1;
+}
+
+int main (int argc, char** argv) {
+    if (argc > 1 && std::strcmp (argv[1], "--check") == 0) {
+        try {
+            return run_check ((argc > 2)? std::strtoul (argv[2], nullptr, 10): 4UL);
+        }
+        catch (std::exception &exception) {
+            std::cerr << "Standard exception: \x1B[1;31m" << exception.what() << "\x1B[0m" << std::endl;
+            return 1;
+        }
+    }
+
+    if (argc > 1 && std::strcmp (argv[1], "--quantized") == 0) {
+        try {
+            run_quantized ((argc > 2)? std::strtoul (argv[2], nullptr, 10): 512UL);
+        }
+        catch (std::exception &exception) {
+            std::cerr << "Standard exception: \x1B[1;31m" << exception.what() << "\x1B[0m" << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (argc > 1 && std::strcmp (argv[1], "--profile") == 0) {
+        try {
+            run_profile ((argc > 2)? std::strtoul (argv[2], nullptr, 10): 512UL);
+        }
+        catch (std::exception &exception) {
+            std::cerr << "Standard exception: \x1B[1;31m" << exception.what() << "\x1B[0m" << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
     try {
         vector v1 = {1,2,3,4};
         std::cout << v1 << std::endl;
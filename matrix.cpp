@@ -4,6 +4,8 @@
 
 #include "matrix.hpp"
 #include "vector.hpp"
+#include "parallel.hpp"
+#include "reduce.hpp"
 #include <stdexcept>
 #include <iomanip>
 #include <cmath>
@@ -28,6 +30,9 @@
 
 namespace linear {
     unsigned long int matrix::glob_id = 0;
+
+    singular_error::singular_error()
+    : std::invalid_argument ("Matrix is singular ") {}
     
     _row::_row (double* list, unsigned long int width)
     : m_data (list), m_width (width) {
@@ -81,8 +86,11 @@ namespace linear {
         if (size < 1)
             throw std::invalid_argument ("Invalid matrix size ");
         m_data = new double[size * size];
-        for (unsigned long int i = 0; i < size * size; i++) 
-            m_data[i] = def;
+        // первое касание строк потоками их узла NUMA
+        parallel::for_range (m_height, m_width, [this, def] (unsigned long int begin, unsigned long int end) {
+            for (unsigned long int i = begin * m_width; i < end * m_width; i++) 
+                m_data[i] = def;
+        });
     }
 
 
@@ -119,8 +127,11 @@ namespace linear {
         if (width < 1)
             throw std::invalid_argument ("Invalid matrix width ");
         m_data = new double[width * height];
-        for (unsigned long int i = 0; i < width * height; i++) 
-            m_data[i] = def;
+        // первое касание строк потоками их узла NUMA
+        parallel::for_range (m_height, m_width, [this, def] (unsigned long int begin, unsigned long int end) {
+            for (unsigned long int i = begin * m_width; i < end * m_width; i++) 
+                m_data[i] = def;
+        });
     }
 
 
@@ -150,10 +161,13 @@ namespace linear {
                   << refer.id << NCOL << std::endl << std::endl << std::endl;
 #endif /* DEBUG */
 
+        m_cache = refer.m_cache;
+        m_release = std::move (refer.m_release);
+        refer.m_release = nullptr;
         refer.m_width = 0;
         refer.m_height = 0;
         refer.m_data = nullptr;
-
+        refer.touch();
     }
 
 
@@ -183,6 +197,30 @@ namespace linear {
     }
 
 
+    /// Constructor over caller-owned buffer { width * height }, not released
+    matrix::matrix (double* data, unsigned long int width, unsigned long int height)
+    : matrix (data, width, height, [] (double*) {}) {}
+
+
+    /// Constructor adopting buffer { width * height }, freed by release
+    matrix::matrix (double* data, unsigned long int width, unsigned long int height, const deleter& release)
+    : m_data (data), m_width (width), m_height (height), m_release (release), id (glob_id++) {
+
+#ifdef DEBUG
+        std::cerr << GCOL << " + " << std::setw (3)
+                  << id   << " matrix over buffer "
+                  << NCOL << std::endl;
+#endif /* DEBUG */
+
+        if (data == nullptr)
+            throw std::invalid_argument ("Invalid buffer ");
+        if (height < 1)
+            throw std::invalid_argument ("Invalid matrix height ");
+        if (width < 1)
+            throw std::invalid_argument ("Invalid matrix width ");
+    }
+
+
     /// Destructor matrix
     matrix::~matrix() {
 
@@ -192,7 +230,7 @@ namespace linear {
                   << NCOL << std::endl;
 #endif /* DEBUG */
 
-        delete[] m_data;
+        release();
     }
 
 
@@ -213,26 +251,109 @@ namespace linear {
         return (m_height == B.m_height) && (m_width == B.m_width);
     }
 
+    /* биты маски кэша */
+    enum {
+        cached_norm = 1,
+        cached_min = 2,
+        cached_max = 4,
+        cached_sum = 8
+    };
+
     double matrix::max() const {
+        if (m_cache.valid & cached_max)
+            return m_cache.max;
         double max = m_data[0];
         for (unsigned long int i = 1; i < m_height * m_width; i++) 
             if (max < m_data[i])
                 max = m_data[i];
+        if (m_cache.enabled) {
+            m_cache.max = max;
+            m_cache.valid |= cached_max;
+        }
         return max;
     }
 
     double matrix::min() const {
+        if (m_cache.valid & cached_min)
+            return m_cache.min;
         double min = m_data[0];
         for (unsigned long int i = 1; i < m_height * m_width; i++) 
             if (min > m_data[i])
                 min = m_data[i];
+        if (m_cache.enabled) {
+            m_cache.min = min;
+            m_cache.valid |= cached_min;
+        }
         return min;
     }
 
+    double matrix::sum() const {
+        if (m_cache.valid & cached_sum)
+            return m_cache.sum;
+        double sum = reduction::sum (m_data, m_width * m_height);
+        if (m_cache.enabled) {
+            m_cache.sum = sum;
+            m_cache.valid |= cached_sum;
+        }
+        return sum;
+    }
+
+    double matrix::norm() const {
+        if (m_cache.valid & cached_norm)
+            return m_cache.norm;
+        double norm = std::sqrt (reduction::dot (m_data, m_data, m_width * m_height));
+        if (m_cache.enabled) {
+            m_cache.norm = norm;
+            m_cache.valid |= cached_norm;
+        }
+        return norm;
+    }
+
+    /* значения не потокобезопасны при одновременных запросах; смена режима
+       reduction не сбрасывает уже посчитанные sum и norm */
+    void matrix::set_cache (bool enabled) {
+        m_cache.enabled = enabled;
+        m_cache.valid = 0;
+    }
+
+    bool matrix::get_cache() const {
+        return m_cache.enabled;
+    }
+
+    void matrix::touch() {
+        m_cache.valid = 0;
+    }
+
+    void matrix::release() {
+        if (m_release)
+            m_release (m_data);
+        else
+            delete[] m_data;
+    }
+
+    /* результат операции из data размера size. Свой буфер заменяется;
+       во внешний результат копируется, если число элементов то же,
+       иначе length_error: внешняя память не подменяется молча */
+    void matrix::adopt (double* data, long unsigned int size) {
+        if (!m_release) {
+            delete[] m_data;
+            m_data = data;
+            return;
+        }
+        if (size != m_width * m_height) {
+            delete[] data;
+            throw std::length_error ("Invalid matrix size ");
+        }
+        for (long unsigned int i = 0; i < size; i++)
+            m_data[i] = data[i];
+        delete[] data;
+    }
+
     matrix matrix::get_transpose() const {
         return matrix (*this).to_transpose();
     }
 
+    /* перестановка элементов не меняет max, min, sum и norm - кэш остаётся */
     matrix& matrix::to_transpose() {
         if (m_height == 1UL) {
             m_height = m_width;
@@ -245,11 +366,10 @@ namespace linear {
             for (unsigned long int i = 0; i < m_height; i++)
                 for (unsigned long int j = 0; j < m_width; j++) 
                     new_data[j * m_height + i] = m_data[i * m_width + j];
-            delete[] m_data;
+            adopt (new_data, m_width * m_height);
             unsigned long int old_height = m_height;
             m_height = m_width;
             m_width = old_height;
-            m_data = new_data;
         }
         return *this;
     }
@@ -259,6 +379,7 @@ namespace linear {
     }
 
     matrix& matrix::operator- () {
+        touch();
         for (unsigned long int i = 0; i < m_width; i++)
             m_data[i] = -m_data[i];
         return *this;
@@ -288,12 +409,11 @@ namespace linear {
                   << refer.id << NCOL << std::endl;
 #endif /* DEBUG */
 
-        if (m_width * m_height != refer.m_width * refer.m_height) {
-            delete[] m_data;
-            m_width = refer.m_width;
-            m_height = refer.m_height;
-            m_data = new double[m_width * m_height];
-        }
+        touch();
+        if (m_width * m_height != refer.m_width * refer.m_height)
+            adopt (new double[refer.m_width * refer.m_height], refer.m_width * refer.m_height);
+        m_width = refer.m_width;
+        m_height = refer.m_height;
         for (unsigned long int i = 0; i < m_width * m_height; i++) 
             m_data[i] = refer.m_data[i];
         return *this;
@@ -310,17 +430,25 @@ namespace linear {
 
         if (&refer == this)
             return *this;
-        delete[] m_data;
+        // внешний буфер остаётся: результат копируется в него
+        if (m_release)
+            return *this = static_cast<const matrix&> (refer);
+        release();
         m_data = refer.m_data;
+        m_cache = refer.m_cache;
+        m_release = std::move (refer.m_release);
         m_width = refer.m_width;
         m_height = refer.m_height;
+        refer.m_release = nullptr;
         refer.m_width = 0;
         refer.m_height = 0;
         refer.m_data = nullptr;
+        refer.touch();
         return *this;
     }
 
     matrix& matrix::operator= (double def) {
+        touch();
         for (unsigned long int i = 0; i < m_width * m_height; i++)
             m_data[i] *= def;
         return *this;
@@ -329,6 +457,7 @@ namespace linear {
     matrix& matrix::operator+= (const matrix& B) {
         if (!is_proport (B))
             throw std::length_error ("Matrix's sizes are different ");
+        touch();
         for (unsigned long int i = 0; i < m_width * m_height; i++)
             m_data[i] += B.m_data[i];
         return *this;
@@ -337,6 +466,7 @@ namespace linear {
     matrix& matrix::operator-= (const matrix& B) {
         if (!is_proport (B))
             throw std::length_error ("Matrix's sizes are different ");
+        touch();
         for (unsigned long int i = 0; i < m_width * m_height; i++)
             m_data[i] -= B.m_data[i];
         return *this;
@@ -345,26 +475,97 @@ namespace linear {
     matrix& matrix::operator*= (const matrix& B) {
         if (!is_isomeric (B))
             throw std::length_error ("Matrixs are not isomeric ");
+        touch();
         double* new_data = new double [m_height * B.m_width];
-        for (unsigned long int i = 0; i < m_height; i++)
-            for (unsigned long int j = 0; j < B.m_width; j++) {
-                new_data[i * B.m_width + j] = 0.;
-                for (unsigned long int r = 0; r < m_width; r++) 
-                   new_data[i * B.m_width + j] += m_data[i * m_width + r] * B.m_data[r * B.m_width + j];
-            }
-        delete[] m_data;
-        m_data = new_data;
+        // строки результата считаются и размещаются потоками узла исходных строк
+        parallel::for_range (m_height, m_width * B.m_width, [this, &B, new_data] (unsigned long int begin, unsigned long int end) {
+            for (unsigned long int i = begin; i < end; i++)
+                for (unsigned long int j = 0; j < B.m_width; j++) {
+                    new_data[i * B.m_width + j] = 0.;
+                    for (unsigned long int r = 0; r < m_width; r++) 
+                       new_data[i * B.m_width + j] += m_data[i * m_width + r] * B.m_data[r * B.m_width + j];
+                }
+        });
+        adopt (new_data, m_height * B.m_width);
         m_width = B.m_width;
         return *this;
     }
 
     matrix& matrix::operator*= (double B) {
+        touch();
         for (unsigned long int i = 0; i < m_width * m_height; i++)
             m_data[i] *= B;
         return *this;
     }
 
 
+    // поэлементные
+    matrix& matrix::to_hadamard (const matrix& B) {
+        if (!is_proport (B))
+            throw std::length_error ("Matrix's sizes are different ");
+        touch();
+        const double* b = B.m_data;
+        parallel::for_range (m_height, m_width, [this, b] (unsigned long int begin, unsigned long int end) {
+            for (unsigned long int i = begin * m_width; i < end * m_width; i++)
+                m_data[i] *= b[i];
+        });
+        return *this;
+    }
+
+    /* v любой ориентации; проход по строкам, v остаётся в кэше */
+    matrix& matrix::add_to_rows (const vector& V) {
+        if (V.m_width * V.m_height != m_width)
+            throw std::length_error ("Matrix's sizes are different ");
+        touch();
+        const double* v = V.m_data;
+        parallel::for_range (m_height, m_width, [this, v] (unsigned long int begin, unsigned long int end) {
+            for (unsigned long int i = begin; i < end; i++)
+                for (unsigned long int j = 0; j < m_width; j++)
+                    m_data[i * m_width + j] += v[j];
+        });
+        return *this;
+    }
+
+    matrix& matrix::add_to_cols (const vector& V) {
+        if (V.m_width * V.m_height != m_height)
+            throw std::length_error ("Matrix's sizes are different ");
+        touch();
+        const double* v = V.m_data;
+        parallel::for_range (m_height, m_width, [this, v] (unsigned long int begin, unsigned long int end) {
+            for (unsigned long int i = begin; i < end; i++)
+                for (unsigned long int j = 0; j < m_width; j++)
+                    m_data[i * m_width + j] += v[i];
+        });
+        return *this;
+    }
+
+    matrix& matrix::mul_to_rows (const vector& V) {
+        if (V.m_width * V.m_height != m_width)
+            throw std::length_error ("Matrix's sizes are different ");
+        touch();
+        const double* v = V.m_data;
+        parallel::for_range (m_height, m_width, [this, v] (unsigned long int begin, unsigned long int end) {
+            for (unsigned long int i = begin; i < end; i++)
+                for (unsigned long int j = 0; j < m_width; j++)
+                    m_data[i * m_width + j] *= v[j];
+        });
+        return *this;
+    }
+
+    matrix& matrix::mul_to_cols (const vector& V) {
+        if (V.m_width * V.m_height != m_height)
+            throw std::length_error ("Matrix's sizes are different ");
+        touch();
+        const double* v = V.m_data;
+        parallel::for_range (m_height, m_width, [this, v] (unsigned long int begin, unsigned long int end) {
+            for (unsigned long int i = begin; i < end; i++)
+                for (unsigned long int j = 0; j < m_width; j++)
+                    m_data[i * m_width + j] *= v[i];
+        });
+        return *this;
+    }
+
+
     // внешние функции
     bool is_proport (const matrix& A, const matrix& B) {
         return (A.m_width == B.m_width) && (A.m_height == B.m_height);
@@ -394,6 +595,59 @@ namespace linear {
         return matrix (B) *= A;
     }
 
+    /* результат пишется одним проходом, без копии A */
+    matrix hadamard (const matrix& A, const matrix& B) {
+        if (!A.is_proport (B))
+            throw std::length_error ("Matrix's sizes are different ");
+        matrix C (A.m_width, A.m_height);
+        const double* a = A.m_data;
+        const double* b = B.m_data;
+        double* c = C.m_data;
+        unsigned long int width = A.m_width;
+        parallel::for_range (A.m_height, width, [a, b, c, width] (unsigned long int begin, unsigned long int end) {
+            for (unsigned long int i = begin * width; i < end * width; i++)
+                c[i] = a[i] * b[i];
+        });
+        return C;
+    }
+
+    /* блок (i, j) результата - A[i][j] * B; строки пишутся подряд */
+    matrix kronecker (const matrix& A, const matrix& B) {
+        unsigned long int width = A.m_width * B.m_width;
+        matrix C (width, A.m_height * B.m_height);
+        const double* a = A.m_data;
+        const double* b = B.m_data;
+        double* c = C.m_data;
+        unsigned long int q = A.m_width, r = B.m_height, s = B.m_width;
+        parallel::for_range (C.m_height, width, [a, b, c, width, q, r, s] (unsigned long int begin, unsigned long int end) {
+            for (unsigned long int row = begin; row < end; row++) {
+                const double* a_row = a + (row / r) * q;
+                const double* b_row = b + (row % r) * s;
+                double* c_row = c + row * width;
+                for (unsigned long int j = 0; j < q; j++)
+                    for (unsigned long int l = 0; l < s; l++)
+                        c_row[j * s + l] = a_row[j] * b_row[l];
+            }
+        });
+        return C;
+    }
+
+    /* A[i] * B[j] без умножения матриц n x 1 и 1 x m; ориентация не важна */
+    matrix outer (const vector& A, const vector& B) {
+        unsigned long int height = A.m_width * A.m_height;
+        unsigned long int width = B.m_width * B.m_height;
+        matrix C (width, height);
+        const double* a = A.m_data;
+        const double* b = B.m_data;
+        double* c = C.m_data;
+        parallel::for_range (height, width, [a, b, c, width] (unsigned long int begin, unsigned long int end) {
+            for (unsigned long int i = begin; i < end; i++)
+                for (unsigned long int j = 0; j < width; j++)
+                    c[i * width + j] = a[i] * b[j];
+        });
+        return C;
+    }
+
 
     // стейтмент вывода
     std::ostream& operator<< (std::ostream& out, const matrix& M) {
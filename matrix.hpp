@@ -4,11 +4,25 @@
 
 #include <iostream>
 #include <initializer_list>
+#include <functional>
+#include <stdexcept>
 
 
 namespace linear {
     class matrix;
     class vector;
+    class matrix_view;
+    class quantized;
+    class bfloat16;
+
+    // освобождение внешнего буфера вместо delete[]
+    typedef std::function<void (double*)> deleter;
+
+    // вырожденная система; остаётся invalid_argument для прежних обработчиков
+    class singular_error: public std::invalid_argument {
+        public:
+            singular_error();
+    };
 
     class _row {
         friend matrix;
@@ -25,6 +39,16 @@ namespace linear {
             double operator[] (long unsigned int index) const;
     };
 
+    /* производные величины, считаются по первому запросу */
+    struct _statistics {
+        bool enabled;        // кэш включён для объекта
+        unsigned char valid; // маска посчитанных величин
+        double norm;
+        double min;
+        double max;
+        double sum;
+    };
+
     class matrix { 
         // внешние функции
         friend bool is_proport (const matrix&, const matrix&);
@@ -34,10 +58,55 @@ namespace linear {
         friend matrix operator* (const matrix&, const matrix&);
         friend matrix operator* (const matrix&, double);
         friend matrix operator* (double, const matrix&);
+        friend matrix hadamard (const matrix&, const matrix&);  // поэлементное произведение
+        friend matrix kronecker (const matrix&, const matrix&); // произведение Кронекера
+        friend matrix outer (const vector&, const vector&);     // внешнее произведение
 
         // стейтмент вывода
         friend std::ostream& operator<< (std::ostream&, const matrix&);
 
+        // структурированные матрицы
+        friend class diagonal;
+        friend class triangular;
+        friend class symmetric;
+        friend class banded;
+
+        // пакетные ядра
+        friend class batch;
+
+        // итерационные методы
+        friend class dense_operator;
+        friend class sparse;
+        friend class jacobi;
+        friend class _krylov;
+
+        // цепочки произведений
+        friend class chain;
+
+        // поэлементные примитивы
+        friend class _elementwise;
+
+        // внешняя память
+        friend class matrix_view;
+        friend matrix_view view (matrix&);
+
+        // пониженная точность
+        friend class quantized;
+        friend class bfloat16;
+        friend matrix operator* (const quantized&, const quantized&);
+        friend matrix operator* (const bfloat16&, const bfloat16&);
+
+        // поддержание при обновлениях
+        friend class maintained_product;
+        friend class maintained_inverse;
+        friend class maintained_cholesky;
+
+        // матрица Грама
+        friend class gram_accumulator;
+
+        // свёртка
+        friend class _grid;
+
         private:
             static long unsigned int glob_id;
 
@@ -45,6 +114,12 @@ namespace linear {
             double* m_data;
             long unsigned int m_width;
             long unsigned int m_height;
+            mutable _statistics m_cache = {false, 0, 0., 0., 0., 0.};
+            deleter m_release; // пустой - буфер выделен new[]
+
+            void touch(); // сброс кэша перед записью в m_data
+            void release(); // освобождение m_data
+            void adopt (double*, long unsigned int size); // результат операции вместо m_data
 
         public:
             const long unsigned int id;
@@ -55,6 +130,12 @@ namespace linear {
             matrix (const matrix&); // копирование
             matrix (matrix&&);  // перемещение
             matrix (const std::initializer_list<std::initializer_list<double>> &list);
+            /* внешний буфер: результаты операций и присваиваний пишутся в него же.
+               Операция, меняющая число элементов (*= на неквадратную, присваивание
+               другого размера), бросает length_error; release вызывается только
+               в деструкторе */
+            explicit matrix (double* data, long unsigned int width, long unsigned int height); // без владения
+            explicit matrix (double* data, long unsigned int width, long unsigned int height, const deleter& release); // во владении
             ~matrix();
 
             // вспомогательные 
@@ -64,6 +145,15 @@ namespace linear {
             bool is_proport (const matrix&) const;  // соразмерность
             double max() const;
             double min() const;
+            double sum() const;
+            double norm() const; // евклидова норма всех элементов
+
+            /* кэш max, min, sum, norm; выключен по умолчанию, копии не наследуют,
+               перемещение переносит. Сбрасывается только записью через методы:
+               ссылка double& из vector::operator[] или внешнее представление,
+               сохранённые и записанные после чтения из кэша, оставят его устаревшим */
+            void set_cache (bool);
+            bool get_cache() const;
             matrix get_transpose() const;
             matrix& to_transpose();
             matrix& operator+ ();
@@ -81,6 +171,13 @@ namespace linear {
             matrix& operator-= (const matrix&);
             matrix& operator*= (const matrix&);
             matrix& operator*= (double);
+
+            // поэлементные
+            matrix& to_hadamard (const matrix&); // A[i][j] *= B[i][j]
+            matrix& add_to_rows (const vector&); // A[i][j] += v[j]
+            matrix& add_to_cols (const vector&); // A[i][j] += v[i]
+            matrix& mul_to_rows (const vector&); // A[i][j] *= v[j]
+            matrix& mul_to_cols (const vector&); // A[i][j] *= v[i]
     };
 }
 
@@ -0,0 +1,278 @@
+#ifndef PARALLEL_CPP
+#define PARALLEL_CPP
+
+
+#include "parallel.hpp"
+#include <stdexcept>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstdlib>
+
+
+#if defined (__linux) || defined (__gnu_linux__) || defined (linux) || defined (__linux__)
+
+#include <pthread.h>
+#include <sched.h>
+
+#define LINEAR_LINUX
+
+#endif /* OPERATING SYSTEM */
+
+
+namespace linear {
+    namespace parallel {
+        /* разбор списка процессоров вида "0-3,8,10-11" */
+        static std::vector<int> parse_cpulist (const std::string& list) {
+            std::vector<int> cpus;
+            std::stringstream stream (list);
+            std::string item;
+            while (std::getline (stream, item, ',')) {
+                if (item.empty() || item[0] == '\n')
+                    continue;
+                long unsigned int dash = item.find ('-');
+                int first = std::atoi (item.c_str());
+                int last = (dash == std::string::npos)? first: std::atoi (item.c_str() + dash + 1);
+                for (int cpu = first; cpu <= last; cpu++)
+                    cpus.push_back (cpu);
+            }
+            return cpus;
+        }
+
+        /* процессоры, доступные процессу */
+        static bool is_allowed (int cpu) {
+#ifdef LINEAR_LINUX
+            cpu_set_t mask;
+            CPU_ZERO (&mask);
+            if (sched_getaffinity (0, sizeof (mask), &mask) != 0)
+                return true;
+            return CPU_ISSET (cpu, &mask);
+#else  /* LINEAR_LINUX */
+            return true;
+#endif /* LINEAR_LINUX */
+        }
+
+
+        /// Host topology: sysfs nodes, LINEAR_NUMA_NODES simulates a split
+        topology::topology() {
+            for (long unsigned int id = 0; ; id++) {
+                std::ifstream file ("/sys/devices/system/node/node" + std::to_string (id) + "/cpulist");
+                if (!file)
+                    break;
+                std::string list;
+                std::getline (file, list);
+                node current = {id, {}};
+                for (int cpu : parse_cpulist (list))
+                    if (is_allowed (cpu))
+                        current.cpus.push_back (cpu);
+                if (!current.cpus.empty())
+                    m_nodes.push_back (current);
+            }
+            if (m_nodes.empty()) {
+                node single = {0, {}};
+                unsigned int count = std::thread::hardware_concurrency();
+                for (unsigned int cpu = 0; cpu < ((count < 1)? 1: count); cpu++)
+                    single.cpus.push_back (cpu);
+                m_nodes.push_back (single);
+            }
+
+            // имитация многоузловой системы на одном узле
+            const char* simulate = std::getenv ("LINEAR_NUMA_NODES");
+            if (simulate != nullptr && std::atoi (simulate) > 0) {
+                std::vector<int> cpus;
+                for (auto &current : m_nodes)
+                    cpus.insert (cpus.end(), current.cpus.begin(), current.cpus.end());
+                long unsigned int count = std::atoi (simulate);
+                long unsigned int per_node = (cpus.size() < count)? 1: cpus.size() / count;
+                m_nodes.clear();
+                for (long unsigned int id = 0; id < count; id++) {
+                    node fake = {id, {}};
+                    for (long unsigned int i = 0; i < per_node; i++)
+                        fake.cpus.push_back (cpus[(id * per_node + i) % cpus.size()]);
+                    m_nodes.push_back (fake);
+                }
+            }
+        }
+
+        const topology& topology::host() {
+            static const topology instance;
+            return instance;
+        }
+
+        long unsigned int topology::nodes() const {
+            return m_nodes.size();
+        }
+
+        long unsigned int topology::workers() const {
+            long unsigned int count = 0;
+            for (auto &current : m_nodes)
+                count += current.cpus.size();
+            return count;
+        }
+
+        const node& topology::operator[] (long unsigned int index) const {
+            if (index >= m_nodes.size())
+                throw std::out_of_range ("Index is out of range ");
+            return m_nodes[index];
+        }
+
+        int topology::cpu_of (long unsigned int worker) const {
+            for (auto &current : m_nodes) {
+                if (worker < current.cpus.size())
+                    return current.cpus[worker];
+                worker -= current.cpus.size();
+            }
+            throw std::out_of_range ("Index is out of range ");
+        }
+
+        long unsigned int topology::node_of (long unsigned int worker) const {
+            for (long unsigned int id = 0; id < m_nodes.size(); id++) {
+                if (worker < m_nodes[id].cpus.size())
+                    return id;
+                worker -= m_nodes[id].cpus.size();
+            }
+            throw std::out_of_range ("Index is out of range ");
+        }
+
+
+        /* закрепление текущего потока за процессором */
+        static void pin (int cpu) {
+#ifdef LINEAR_LINUX
+            cpu_set_t mask;
+            CPU_ZERO (&mask);
+            CPU_SET (cpu, &mask);
+            pthread_setaffinity_np (pthread_self(), sizeof (mask), &mask);
+#else  /* LINEAR_LINUX */
+            (void) cpu;
+#endif /* LINEAR_LINUX */
+        }
+
+        static std::atomic<long unsigned int> requested (0);
+
+        void set_workers (long unsigned int count) {
+            requested = count;
+        }
+
+        long unsigned int get_workers() {
+            long unsigned int count = requested;
+            return (count > 0)? count: topology::host().workers();
+        }
+
+        /* постоянные исполнители: i-й закреплён за host.cpu_of (i) и ждёт
+           заданий for_range. Создаются по первому требованию, живут до выхода */
+        class _pool {
+            private:
+                std::vector<std::thread> m_threads;
+                std::mutex m_run;  // одно задание за раз
+                std::mutex m_lock; // поля задания ниже
+                std::condition_variable m_wake;
+                std::condition_variable m_done;
+                const range_body* m_body = nullptr;
+                long unsigned int m_count = 0;
+                long unsigned int m_workers = 0;
+                long unsigned int m_generation = 0;
+                long unsigned int m_pending = 0;
+                std::vector<std::exception_ptr> m_errors;
+                bool m_stop = false;
+
+                void loop (long unsigned int worker, int cpu);
+
+            public:
+                static thread_local bool inside; // текущий поток - исполнитель
+
+                ~_pool();
+                static _pool& instance();
+                void run (long unsigned int count, long unsigned int workers, const range_body& body);
+        };
+
+        thread_local bool _pool::inside = false;
+
+        _pool::~_pool() {
+            {
+                std::lock_guard<std::mutex> lock (m_lock);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            for (auto &thread : m_threads)
+                thread.join();
+        }
+
+        _pool& _pool::instance() {
+            static _pool pool;
+            return pool;
+        }
+
+        void _pool::loop (long unsigned int worker, int cpu) {
+            pin (cpu);
+            inside = true;
+            long unsigned int seen = 0;
+            std::unique_lock<std::mutex> lock (m_lock);
+            for (;;) {
+                m_wake.wait (lock, [this, &seen] { return m_stop || m_generation != seen; });
+                if (m_stop)
+                    return;
+                seen = m_generation;
+                if (worker >= m_workers)
+                    continue;
+                const range_body& body = *m_body;
+                long unsigned int begin = m_count * worker / m_workers;
+                long unsigned int end = m_count * (worker + 1) / m_workers;
+                lock.unlock();
+                try {
+                    body (begin, end);
+                } catch (...) {
+                    m_errors[worker] = std::current_exception();
+                }
+                lock.lock();
+                if (--m_pending == 0)
+                    m_done.notify_one();
+            }
+        }
+
+        void _pool::run (long unsigned int count, long unsigned int workers, const range_body& body) {
+            const topology& host = topology::host();
+            std::lock_guard<std::mutex> guard (m_run);
+            std::unique_lock<std::mutex> lock (m_lock);
+            while (m_threads.size() < workers) {
+                long unsigned int worker = m_threads.size();
+                m_threads.emplace_back (&_pool::loop, this, worker, host.cpu_of (worker % host.workers()));
+            }
+            m_body = &body;
+            m_count = count;
+            m_workers = workers;
+            m_errors.assign (workers, nullptr);
+            m_pending = workers;
+            m_generation++;
+            m_wake.notify_all();
+            m_done.wait (lock, [this] { return m_pending == 0; });
+            m_body = nullptr;
+            for (auto &error : m_errors)
+                if (error)
+                    std::rethrow_exception (error);
+        }
+
+        /// Splits [0, count) into contiguous blocks, one per worker in node order.
+        /// The split depends on count and get_workers(): while the worker count
+        /// stays the same, a buffer first-touched here is later processed by the
+        /// same pinned worker. After set_workers changes it, blocks may move.
+        /// Nested calls from inside a body run serially.
+        void for_range (long unsigned int count, long unsigned int cost, const range_body& body) {
+            long unsigned int workers = get_workers();
+            if (workers < 2 || count < 2 || count * cost < grain || _pool::inside) {
+                body (0, count);
+                return;
+            }
+            if (workers > count)
+                workers = count;
+            _pool::instance().run (count, workers, body);
+        }
+    }
+}
+
+
+#endif /* PARALLEL_CPP */
@@ -0,0 +1,51 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+
+#include <functional>
+#include <vector>
+
+
+namespace linear {
+    namespace parallel {
+        // минимальный объём работы (в элементах), ради которого запускаются потоки
+        const long unsigned int grain = 1UL << 15;
+
+        // узел NUMA и его процессоры
+        struct node {
+            long unsigned int id;
+            std::vector<int> cpus;
+        };
+
+        class topology {
+            private:
+                std::vector<node> m_nodes;
+
+                topology();
+
+            public:
+                static const topology& host();
+
+                long unsigned int nodes() const;
+                long unsigned int workers() const;
+                const node& operator[] (long unsigned int index) const;
+
+                // процессор и узел для потока-исполнителя
+                int cpu_of (long unsigned int worker) const;
+                long unsigned int node_of (long unsigned int worker) const;
+        };
+
+        // [begin, end) строк, обрабатываемых исполнителем
+        typedef std::function<void (long unsigned int, long unsigned int)> range_body;
+
+        // блоки идут постоянным закреплённым исполнителям; вложенный вызов - последовательно
+        void for_range (long unsigned int count, long unsigned int cost, const range_body& body);
+
+        // число исполнителей for_range; 0 - по топологии хоста
+        void set_workers (long unsigned int count);
+        long unsigned int get_workers();
+    }
+}
+
+
+#endif /* PARALLEL_HPP */
@@ -0,0 +1,233 @@
+#ifndef PROFILE_CPP
+#define PROFILE_CPP
+
+
+#include "profile.hpp"
+#include "parallel.hpp"
+#include <stdexcept>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+
+
+#if defined (__linux) || defined (__gnu_linux__) || defined (linux) || defined (__linux__)
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define LINEAR_PERF
+
+#endif /* OPERATING SYSTEM */
+
+
+namespace linear {
+    namespace profile {
+        const char* event_name (event e) {
+            static const char* names[events] = {
+                "cycles", "instructions", "L1d misses", "LLC misses", "dTLB misses", "branch misses"
+            };
+            if (e < 0 || e >= events)
+                throw std::out_of_range ("Index is out of range ");
+            return names[e];
+        }
+
+        bool sample::has (event e) const {
+            return valid[e];
+        }
+
+
+        /* пиковые FLOP/такт одного ядра по набору инструкций сборки */
+        static double core_flops_per_cycle() {
+#if defined (__AVX512F__)
+            return 2 * 2 * 8.; // два FMA-порта по 8 double
+#elif defined (__AVX2__) && defined (__FMA__)
+            return 2 * 2 * 4.;
+#elif defined (__AVX__)
+            return 2 * 4.;     // сложение и умножение по 4 double
+#else
+            return 2 * 2.;     // SSE2
+#endif
+        }
+
+        /* пропускная способность памяти по тесту triad */
+        static double measure_bandwidth() {
+            const long unsigned int size = 1UL << 22; // 3 * 32 МБ, больше LLC
+            double* a = new double[size];
+            double* b = new double[size];
+            double* c = new double[size];
+            parallel::for_range (size, 1UL, [a, b, c] (long unsigned int begin, long unsigned int end) {
+                for (long unsigned int i = begin; i < end; i++) {
+                    a[i] = 0.;
+                    b[i] = 1.;
+                    c[i] = 2.;
+                }
+            });
+            double best = 0.;
+            for (int repeat = 0; repeat < 3; repeat++) {
+                auto start = std::chrono::steady_clock::now();
+                parallel::for_range (size, 1UL, [a, b, c] (long unsigned int begin, long unsigned int end) {
+                    for (long unsigned int i = begin; i < end; i++)
+                        a[i] = b[i] + 3. * c[i];
+                });
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                double rate = 3. * size * sizeof (double) / elapsed.count();
+                if (rate > best)
+                    best = rate;
+            }
+            delete[] a;
+            delete[] b;
+            delete[] c;
+            return best;
+        }
+
+        const roofline& roofline::host() {
+            static const roofline instance = {
+                core_flops_per_cycle(),
+                measure_bandwidth()
+            };
+            return instance;
+        }
+
+
+#ifdef LINEAR_PERF
+        /* открытие счётчика для текущего процесса и его потоков */
+        static int open_event (__u32 type, __u64 config) {
+            perf_event_attr attr;
+            std::memset (&attr, 0, sizeof (attr));
+            attr.size = sizeof (attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            return syscall (SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+
+        static __u64 cache_event (__u64 cache) {
+            return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        }
+#endif /* LINEAR_PERF */
+
+
+        /// Opens every counter separately so a missing event does not disable the rest
+        counters::counters() {
+            for (int e = 0; e < events; e++)
+                m_fd[e] = -1;
+
+#ifdef LINEAR_PERF
+            m_fd[cycles]        = open_event (PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+            int error = errno;
+            m_fd[instructions]  = open_event (PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+            m_fd[l1_misses]     = open_event (PERF_TYPE_HW_CACHE, cache_event (PERF_COUNT_HW_CACHE_L1D));
+            m_fd[llc_misses]    = open_event (PERF_TYPE_HW_CACHE, cache_event (PERF_COUNT_HW_CACHE_LL));
+            m_fd[dtlb_misses]   = open_event (PERF_TYPE_HW_CACHE, cache_event (PERF_COUNT_HW_CACHE_DTLB));
+            m_fd[branch_misses] = open_event (PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+            if (!available())
+                m_reason = std::string ("perf_event_open: ") + std::strerror (error);
+#else  /* LINEAR_PERF */
+            m_reason = "perf_event_open is not supported on this system";
+#endif /* LINEAR_PERF */
+
+        }
+
+        counters::~counters() {
+#ifdef LINEAR_PERF
+            for (int e = 0; e < events; e++)
+                if (m_fd[e] >= 0)
+                    close (m_fd[e]);
+#endif /* LINEAR_PERF */
+        }
+
+        bool counters::available() const {
+            for (int e = 0; e < events; e++)
+                if (m_fd[e] >= 0)
+                    return true;
+            return false;
+        }
+
+        const std::string& counters::reason() const {
+            return m_reason;
+        }
+
+        void counters::start() {
+#ifdef LINEAR_PERF
+            for (int e = 0; e < events; e++)
+                if (m_fd[e] >= 0) {
+                    ioctl (m_fd[e], PERF_EVENT_IOC_RESET, 0);
+                    ioctl (m_fd[e], PERF_EVENT_IOC_ENABLE, 0);
+                }
+#endif /* LINEAR_PERF */
+        }
+
+        sample counters::stop (double seconds) {
+            sample result;
+            result.seconds = seconds;
+            for (int e = 0; e < events; e++) {
+                result.count[e] = 0;
+                result.valid[e] = false;
+#ifdef LINEAR_PERF
+                if (m_fd[e] < 0)
+                    continue;
+                ioctl (m_fd[e], PERF_EVENT_IOC_DISABLE, 0);
+                __u64 value = 0;
+                if (read (m_fd[e], &value, sizeof (value)) == sizeof (value)) {
+                    result.count[e] = value;
+                    result.valid[e] = true;
+                }
+#endif /* LINEAR_PERF */
+            }
+            return result;
+        }
+
+
+        sample measure (counters& probe, const std::function<void ()>& kernel) {
+            probe.start();
+            auto start = std::chrono::steady_clock::now();
+            kernel();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            return probe.stop (elapsed.count());
+        }
+
+        void report (std::ostream& out, const std::string& name, const sample& S, double flops, double bytes) {
+            const roofline& roof = roofline::host();
+            std::ios state (nullptr);
+            state.copyfmt (out);
+            out << std::setprecision (4)
+                << name << ": " << S.seconds * 1e3 << " ms, "
+                << flops / S.seconds * 1e-9 << " GFLOP/s, "
+                << bytes / S.seconds * 1e-9 << " GB/s (model), "
+                << roof.bandwidth * 1e-9 << " GB/s (host)" << std::endl;
+
+            for (int e = 0; e < events; e++)
+                if (S.has (event (e)))
+                    out << "    " << std::setw (14) << std::left << event_name (event (e))
+                        << std::right << S.count[e] << std::endl;
+
+            if (S.has (instructions) && S.has (cycles) && S.count[cycles] > 0)
+                out << "    IPC           " << double (S.count[instructions]) / S.count[cycles] << std::endl;
+            if (S.has (llc_misses))
+                out << "    LLC traffic   " << 64. * S.count[llc_misses] / S.seconds * 1e-9 << " GB/s" << std::endl;
+
+            if (S.has (cycles) && S.count[cycles] > 0) {
+                // крыша в FLOP на такт ядра: счётчик с inherit суммирует такты
+                // всех потоков, поэтому частота - суммарная по ядрам, а пик - одного ядра
+                double frequency = S.count[cycles] / S.seconds;
+                double memory_bound = flops / bytes * roof.bandwidth / frequency;
+                double bound = (memory_bound < roof.flops_per_cycle)? memory_bound: roof.flops_per_cycle;
+                out << "    FLOP/cycle    " << flops / S.count[cycles]
+                    << " of " << bound << " attainable ("
+                    << ((memory_bound < roof.flops_per_cycle)? "memory": "compute") << " bound, peak "
+                    << roof.flops_per_cycle << ")" << std::endl;
+            } else
+                out << "    counters unavailable, wall-clock only" << std::endl;
+            out.copyfmt (state);
+        }
+    }
+}
+
+
+#endif /* PROFILE_CPP */
@@ -0,0 +1,69 @@
+#ifndef PROFILE_HPP
+#define PROFILE_HPP
+
+
+#include <iostream>
+#include <functional>
+#include <string>
+
+
+namespace linear {
+    namespace profile {
+        // аппаратные события, снимаемые с ядер
+        enum event {
+            cycles = 0,
+            instructions,
+            l1_misses,
+            llc_misses,
+            dtlb_misses,
+            branch_misses,
+            events
+        };
+
+        const char* event_name (event);
+
+        // результат одного замера
+        struct sample {
+            double seconds;
+            long unsigned int count[events];
+            bool valid[events];
+
+            bool has (event) const;
+        };
+
+        // оценка "крыши" производительности для хоста
+        struct roofline {
+            double flops_per_cycle; // пиковые FLOP за такт одного ядра
+            double bandwidth;       // измеренная пропускная способность памяти, байт/с
+
+            static const roofline& host();
+        };
+
+        class counters {
+            private:
+                int m_fd[events];
+                std::string m_reason;
+
+            public:
+                counters();
+                counters (const counters&) = delete;
+                counters& operator= (const counters&) = delete;
+                ~counters();
+
+                bool available() const; // открыт хотя бы один счётчик
+                const std::string& reason() const; // почему счётчики недоступны
+
+                void start();
+                sample stop (double seconds);
+        };
+
+        /// Runs the kernel once under the counters
+        sample measure (counters&, const std::function<void ()>& kernel);
+
+        /// flops and bytes are the model work and compulsory memory traffic of one call
+        void report (std::ostream&, const std::string& name, const sample&, double flops, double bytes);
+    }
+}
+
+
+#endif /* PROFILE_HPP */
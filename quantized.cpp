@@ -0,0 +1,318 @@
+#ifndef QUANTIZED_CPP
+#define QUANTIZED_CPP
+
+
+#include "quantized.hpp"
+#include "parallel.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+
+#if defined (__AVX512F__) && (defined (__AVX512VNNI__) || defined (__AVX512BF16__))
+
+#include <immintrin.h>
+
+#endif /* AVX-512 */
+
+
+namespace linear {
+    // int8
+    quantized::quantized (const matrix& M, quant_axis axis)
+    : m_width (M.m_width), m_height (M.m_height), m_axis (axis) {
+        long unsigned int groups = (axis == per_row)? m_height: m_width;
+        long unsigned int length = (axis == per_row)? m_width: m_height;
+        m_data.assign ((axis == per_row)? m_height * depth(): depth() * columns(), 0);
+        m_scale.resize (groups);
+        m_zero.resize (groups);
+        m_sum.assign ((axis == per_row)? groups: columns(), 0);
+
+        for (long unsigned int g = 0; g < groups; g++) {
+            auto element = [&M, axis, g] (long unsigned int t) {
+                return (axis == per_row)? M.m_data[g * M.m_width + t]: M.m_data[t * M.m_width + g];
+            };
+            // ноль всегда представим точно
+            double low = 0., high = 0.;
+            for (long unsigned int t = 0; t < length; t++) {
+                low = std::min (low, element (t));
+                high = std::max (high, element (t));
+            }
+            double scale = (high - low) / 255.;
+            if (scale == 0.)
+                scale = 1.;
+            long int zero = std::lround (-128. - low / scale);
+            zero = std::min (127L, std::max (-128L, zero));
+            m_scale[g] = float (scale);
+            m_zero[g] = std::int32_t (zero);
+
+            for (long unsigned int t = 0; t < length; t++) {
+                long int q = std::lround (element (t) / scale) + zero;
+                q = std::min (127L, std::max (-128L, q));
+                long unsigned int index = (axis == per_row)? offset (g, t): offset (t, g);
+                m_data[index] = std::int8_t (q);
+                m_sum[g] += std::int32_t (q);
+            }
+        }
+    }
+
+    long unsigned int quantized::depth() const {
+        long unsigned int length = (m_axis == per_row)? m_width: m_height;
+        return (length + 3) / 4 * 4;
+    }
+
+    long unsigned int quantized::columns() const {
+        return (m_width + 15) / 16 * 16;
+    }
+
+    long unsigned int quantized::offset (long unsigned int row, long unsigned int col) const {
+        if (m_axis == per_row)
+            return row * depth() + col;
+        return ((row / 4) * columns() + col) * 4 + row % 4;
+    }
+
+    long unsigned int quantized::get_width() const {
+        return m_width;
+    }
+
+    long unsigned int quantized::get_height() const {
+        return m_height;
+    }
+
+    quant_axis quantized::get_axis() const {
+        return m_axis;
+    }
+
+    long unsigned int quantized::get_bytes() const {
+        return m_data.size() + m_scale.size() * sizeof (float) + (m_zero.size() + m_sum.size()) * sizeof (std::int32_t);
+    }
+
+    matrix quantized::dequantize() const {
+        matrix result (m_width, m_height);
+        for (long unsigned int i = 0; i < m_height; i++)
+            for (long unsigned int j = 0; j < m_width; j++) {
+                long unsigned int g = (m_axis == per_row)? i: j;
+                result.m_data[i * m_width + j] = double (m_scale[g]) * (m_data[offset (i, j)] - m_zero[g]);
+            }
+        return result;
+    }
+
+
+    // bfloat16
+    static std::uint16_t to_bfloat16 (double value) {
+        float single = float (value);
+        std::uint32_t bits;
+        std::memcpy (&bits, &single, sizeof (bits));
+        bits += 0x7FFFU + ((bits >> 16) & 1U);
+        return std::uint16_t (bits >> 16);
+    }
+
+    static float from_bfloat16 (std::uint16_t value) {
+        std::uint32_t bits = std::uint32_t (value) << 16;
+        float single;
+        std::memcpy (&single, &bits, sizeof (single));
+        return single;
+    }
+
+    bfloat16::bfloat16 (const matrix& M, quant_axis axis)
+    : m_width (M.m_width), m_height (M.m_height), m_axis (axis) {
+        m_data.assign ((axis == per_row)? m_height * depth(): depth() * columns(), 0);
+        for (long unsigned int i = 0; i < m_height; i++)
+            for (long unsigned int j = 0; j < m_width; j++)
+                m_data[offset (i, j)] = to_bfloat16 (M.m_data[i * m_width + j]);
+    }
+
+    long unsigned int bfloat16::depth() const {
+        long unsigned int length = (m_axis == per_row)? m_width: m_height;
+        return (length + 1) / 2 * 2;
+    }
+
+    long unsigned int bfloat16::columns() const {
+        return (m_width + 15) / 16 * 16;
+    }
+
+    long unsigned int bfloat16::offset (long unsigned int row, long unsigned int col) const {
+        if (m_axis == per_row)
+            return row * depth() + col;
+        return ((row / 2) * columns() + col) * 2 + row % 2;
+    }
+
+    long unsigned int bfloat16::get_width() const {
+        return m_width;
+    }
+
+    long unsigned int bfloat16::get_height() const {
+        return m_height;
+    }
+
+    quant_axis bfloat16::get_axis() const {
+        return m_axis;
+    }
+
+    long unsigned int bfloat16::get_bytes() const {
+        return m_data.size() * sizeof (std::uint16_t);
+    }
+
+    matrix bfloat16::dequantize() const {
+        matrix result (m_width, m_height);
+        for (long unsigned int i = 0; i < m_height; i++)
+            for (long unsigned int j = 0; j < m_width; j++)
+                result.m_data[i * m_width + j] = from_bfloat16 (m_data[offset (i, j)]);
+        return result;
+    }
+
+
+    /* строка произведения: dot[j] = sum q_a[k] * q_b[k][j], j < columns.
+       vpdpbusd умножает беззнаковые байты на знаковые, поэтому a смещается
+       на 128, а лишние 128 * sum q_b вычитаются */
+#if defined (__AVX512F__) && defined (__AVX512VNNI__)
+
+    static void int8_row (const std::int8_t* a, const std::int8_t* b, const std::int32_t* sum,
+                          std::int32_t* dot, long unsigned int depth, long unsigned int columns) {
+        const __m512i bias = _mm512_set1_epi32 (128);
+        long unsigned int j = 0;
+        for (; j + 64 <= columns; j += 64) {
+            __m512i c0 = _mm512_setzero_si512(), c1 = _mm512_setzero_si512();
+            __m512i c2 = _mm512_setzero_si512(), c3 = _mm512_setzero_si512();
+            for (long unsigned int g = 0; g < depth / 4; g++) {
+                std::uint32_t quad;
+                std::memcpy (&quad, a + 4 * g, sizeof (quad));
+                __m512i av = _mm512_set1_epi32 (int (quad ^ 0x80808080U));
+                const std::int8_t* row = b + (g * columns + j) * 4;
+                c0 = _mm512_dpbusd_epi32 (c0, av, _mm512_loadu_si512 (row));
+                c1 = _mm512_dpbusd_epi32 (c1, av, _mm512_loadu_si512 (row + 64));
+                c2 = _mm512_dpbusd_epi32 (c2, av, _mm512_loadu_si512 (row + 128));
+                c3 = _mm512_dpbusd_epi32 (c3, av, _mm512_loadu_si512 (row + 192));
+            }
+            _mm512_storeu_si512 (dot + j,      _mm512_sub_epi32 (c0, _mm512_mullo_epi32 (_mm512_loadu_si512 (sum + j), bias)));
+            _mm512_storeu_si512 (dot + j + 16, _mm512_sub_epi32 (c1, _mm512_mullo_epi32 (_mm512_loadu_si512 (sum + j + 16), bias)));
+            _mm512_storeu_si512 (dot + j + 32, _mm512_sub_epi32 (c2, _mm512_mullo_epi32 (_mm512_loadu_si512 (sum + j + 32), bias)));
+            _mm512_storeu_si512 (dot + j + 48, _mm512_sub_epi32 (c3, _mm512_mullo_epi32 (_mm512_loadu_si512 (sum + j + 48), bias)));
+        }
+        for (; j < columns; j += 16) {
+            __m512i c0 = _mm512_setzero_si512();
+            for (long unsigned int g = 0; g < depth / 4; g++) {
+                std::uint32_t quad;
+                std::memcpy (&quad, a + 4 * g, sizeof (quad));
+                __m512i av = _mm512_set1_epi32 (int (quad ^ 0x80808080U));
+                c0 = _mm512_dpbusd_epi32 (c0, av, _mm512_loadu_si512 (b + (g * columns + j) * 4));
+            }
+            _mm512_storeu_si512 (dot + j, _mm512_sub_epi32 (c0, _mm512_mullo_epi32 (_mm512_loadu_si512 (sum + j), bias)));
+        }
+    }
+
+#else  /* AVX512VNNI */
+
+    static void int8_row (const std::int8_t* a, const std::int8_t* b, const std::int32_t*,
+                          std::int32_t* dot, long unsigned int depth, long unsigned int columns) {
+        for (long unsigned int j = 0; j < columns; j++)
+            dot[j] = 0;
+        for (long unsigned int g = 0; g < depth / 4; g++) {
+            std::int32_t a0 = a[4 * g], a1 = a[4 * g + 1], a2 = a[4 * g + 2], a3 = a[4 * g + 3];
+            const std::int8_t* row = b + g * columns * 4;
+            for (long unsigned int j = 0; j < columns; j++)
+                dot[j] += a0 * row[4 * j] + a1 * row[4 * j + 1] + a2 * row[4 * j + 2] + a3 * row[4 * j + 3];
+        }
+    }
+
+#endif /* AVX512VNNI */
+
+#if defined (__AVX512F__) && defined (__AVX512BF16__)
+
+    static void bf16_row (const std::uint16_t* a, const std::uint16_t* b, float* dot,
+                          long unsigned int depth, long unsigned int columns) {
+        long unsigned int j = 0;
+        for (; j + 64 <= columns; j += 64) {
+            __m512 c0 = _mm512_setzero_ps(), c1 = _mm512_setzero_ps();
+            __m512 c2 = _mm512_setzero_ps(), c3 = _mm512_setzero_ps();
+            for (long unsigned int g = 0; g < depth / 2; g++) {
+                std::uint32_t pair;
+                std::memcpy (&pair, a + 2 * g, sizeof (pair));
+                __m512bh av = (__m512bh) _mm512_set1_epi32 (int (pair));
+                const std::uint16_t* row = b + (g * columns + j) * 2;
+                c0 = _mm512_dpbf16_ps (c0, av, (__m512bh) _mm512_loadu_si512 (row));
+                c1 = _mm512_dpbf16_ps (c1, av, (__m512bh) _mm512_loadu_si512 (row + 32));
+                c2 = _mm512_dpbf16_ps (c2, av, (__m512bh) _mm512_loadu_si512 (row + 64));
+                c3 = _mm512_dpbf16_ps (c3, av, (__m512bh) _mm512_loadu_si512 (row + 96));
+            }
+            _mm512_storeu_ps (dot + j, c0);
+            _mm512_storeu_ps (dot + j + 16, c1);
+            _mm512_storeu_ps (dot + j + 32, c2);
+            _mm512_storeu_ps (dot + j + 48, c3);
+        }
+        for (; j < columns; j += 16) {
+            __m512 c0 = _mm512_setzero_ps();
+            for (long unsigned int g = 0; g < depth / 2; g++) {
+                std::uint32_t pair;
+                std::memcpy (&pair, a + 2 * g, sizeof (pair));
+                __m512bh av = (__m512bh) _mm512_set1_epi32 (int (pair));
+                c0 = _mm512_dpbf16_ps (c0, av, (__m512bh) _mm512_loadu_si512 (b + (g * columns + j) * 2));
+            }
+            _mm512_storeu_ps (dot + j, c0);
+        }
+    }
+
+#else  /* AVX512BF16 */
+
+    static void bf16_row (const std::uint16_t* a, const std::uint16_t* b, float* dot,
+                          long unsigned int depth, long unsigned int columns) {
+        for (long unsigned int j = 0; j < columns; j++)
+            dot[j] = 0.f;
+        for (long unsigned int g = 0; g < depth / 2; g++) {
+            float a0 = from_bfloat16 (a[2 * g]), a1 = from_bfloat16 (a[2 * g + 1]);
+            const std::uint16_t* row = b + g * columns * 2;
+            for (long unsigned int j = 0; j < columns; j++)
+                dot[j] += a0 * from_bfloat16 (row[2 * j]) + a1 * from_bfloat16 (row[2 * j + 1]);
+        }
+    }
+
+#endif /* AVX512BF16 */
+
+
+    // внешние функции
+    /* sA sB sum (qa - zA)(qb - zB) раскрывается через суммы строк и столбцов */
+    matrix operator* (const quantized& A, const quantized& B) {
+        if (A.m_axis != per_row || B.m_axis != per_column)
+            throw std::invalid_argument ("Invalid quantization axis ");
+        if (A.m_width != B.m_height)
+            throw std::length_error ("Matrixs are not isomeric ");
+        long unsigned int depth = A.depth(), columns = B.columns(), width = B.m_width;
+        long long int length = (long long int) A.m_width;
+        matrix C (width, A.m_height);
+        double* c = C.m_data;
+        parallel::for_range (A.m_height, depth * columns, [&A, &B, c, depth, columns, width, length] (long unsigned int begin, long unsigned int end) {
+            std::vector<std::int32_t> dot (columns);
+            for (long unsigned int i = begin; i < end; i++) {
+                int8_row (A.m_data.data() + i * depth, B.m_data.data(), B.m_sum.data(), dot.data(), depth, columns);
+                long long int zero_a = A.m_zero[i], sum_a = A.m_sum[i];
+                for (long unsigned int j = 0; j < width; j++) {
+                    long long int value = dot[j] - B.m_zero[j] * sum_a - zero_a * B.m_sum[j] + length * zero_a * B.m_zero[j];
+                    c[i * width + j] = double (A.m_scale[i]) * B.m_scale[j] * double (value);
+                }
+            }
+        });
+        return C;
+    }
+
+    matrix operator* (const bfloat16& A, const bfloat16& B) {
+        if (A.m_axis != per_row || B.m_axis != per_column)
+            throw std::invalid_argument ("Invalid quantization axis ");
+        if (A.m_width != B.m_height)
+            throw std::length_error ("Matrixs are not isomeric ");
+        long unsigned int depth = A.depth(), columns = B.columns(), width = B.m_width;
+        matrix C (width, A.m_height);
+        double* c = C.m_data;
+        parallel::for_range (A.m_height, depth * columns, [&A, &B, c, depth, columns, width] (long unsigned int begin, long unsigned int end) {
+            std::vector<float> dot (columns);
+            for (long unsigned int i = begin; i < end; i++) {
+                bf16_row (A.m_data.data() + i * depth, B.m_data.data(), dot.data(), depth, columns);
+                for (long unsigned int j = 0; j < width; j++)
+                    c[i * width + j] = dot[j];
+            }
+        });
+        return C;
+    }
+}
+
+
+#endif /* QUANTIZED_CPP */
@@ -0,0 +1,83 @@
+#ifndef QUANTIZED_HPP
+#define QUANTIZED_HPP
+
+
+#include "matrix.hpp"
+#include <cstdint>
+#include <vector>
+
+
+namespace linear {
+    // ось квантования: левый сомножитель - по строкам, правый - по столбцам
+    enum quant_axis {
+        per_row,
+        per_column
+    };
+
+    /* int8 с масштабом и нулём на строку или столбец: x = scale * (q - zero).
+       Строки (per_row) хранятся подряд, глубина дополнена до 4; столбцы
+       (per_column) упакованы четвёрками по глубине [k / 4][j][k % 4] под
+       vpdpbusd, ширина дополнена до 16. Дополнение - нули */
+    class quantized {
+        // внешние функции
+        friend matrix operator* (const quantized&, const quantized&);
+
+        private:
+            std::vector<std::int8_t> m_data;
+            long unsigned int m_width;
+            long unsigned int m_height;
+            quant_axis m_axis;
+            std::vector<float> m_scale;
+            std::vector<std::int32_t> m_zero;
+            std::vector<std::int32_t> m_sum; // сумма q по строке или столбцу
+
+            long unsigned int depth() const;   // глубина с дополнением
+            long unsigned int columns() const; // ширина с дополнением
+            long unsigned int offset (long unsigned int row, long unsigned int col) const;
+
+        public:
+            explicit quantized (const matrix&, quant_axis axis = per_row);
+
+            // вспомогательные
+            long unsigned int get_width() const;
+            long unsigned int get_height() const;
+            quant_axis get_axis() const;
+            long unsigned int get_bytes() const; // память значений, масштабов и нулей
+            matrix dequantize() const;
+    };
+
+    /* bfloat16: старшие 16 бит float, округление к чётному.
+       Раскладка как у quantized, пары по глубине [k / 2][j][k % 2] под vdpbf16ps */
+    class bfloat16 {
+        // внешние функции
+        friend matrix operator* (const bfloat16&, const bfloat16&);
+
+        private:
+            std::vector<std::uint16_t> m_data;
+            long unsigned int m_width;
+            long unsigned int m_height;
+            quant_axis m_axis;
+
+            long unsigned int depth() const;
+            long unsigned int columns() const;
+            long unsigned int offset (long unsigned int row, long unsigned int col) const;
+
+        public:
+            explicit bfloat16 (const matrix&, quant_axis axis = per_row);
+
+            // вспомогательные
+            long unsigned int get_width() const;
+            long unsigned int get_height() const;
+            quant_axis get_axis() const;
+            long unsigned int get_bytes() const;
+            matrix dequantize() const;
+    };
+
+    // A по строкам, B по столбцам; накопление int32 / float, результат в double.
+    // int8: глубина до 2^17 без переполнения int32
+    matrix operator* (const quantized&, const quantized&);
+    matrix operator* (const bfloat16&, const bfloat16&);
+}
+
+
+#endif /* QUANTIZED_HPP */
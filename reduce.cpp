@@ -0,0 +1,161 @@
+#ifndef REDUCE_CPP
+#define REDUCE_CPP
+
+
+#include "reduce.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+
+namespace linear {
+    namespace reduction {
+        static std::atomic<int> current (fast);
+
+        // длина блока воспроизводимого режима; не зависит от числа потоков
+        static const long unsigned int block = 1024;
+
+        void set_mode (mode value) {
+            current = value;
+        }
+
+        mode get_mode() {
+            return mode (current.load());
+        }
+
+
+        /* слагаемые свёрток */
+        struct products {
+            const double* a;
+            const double* b;
+            long unsigned int sa, sb;
+
+            double operator() (long unsigned int i) const {
+                return a[i * sa] * b[i * sb];
+            }
+        };
+
+        struct contiguous {
+            const double* a;
+            const double* b;
+
+            double operator() (long unsigned int i) const {
+                return a[i] * b[i];
+            }
+        };
+
+        struct elements {
+            const double* a;
+
+            double operator() (long unsigned int i) const {
+                return a[i];
+            }
+        };
+
+
+        /* воспроизводимый блок: 4 полосы, фиксированный порядок, без FMA */
+        template <class Term>
+        __attribute__ ((optimize ("fp-contract=off")))
+        static double fixed_lanes (const Term& term, long unsigned int begin, long unsigned int end) {
+            double s0 = 0., s1 = 0., s2 = 0., s3 = 0.;
+            long unsigned int i = begin;
+            for (; i + 4 <= end; i += 4) {
+                s0 += term (i);
+                s1 += term (i + 1);
+                s2 += term (i + 2);
+                s3 += term (i + 3);
+            }
+            for (; i < end; i++)
+                s0 += term (i);
+            return (s0 + s1) + (s2 + s3);
+        }
+
+        /* быстрый отрезок: 8 полос, FMA разрешена */
+        template <class Term>
+        static double free_lanes (const Term& term, long unsigned int begin, long unsigned int end) {
+            double s0 = 0., s1 = 0., s2 = 0., s3 = 0., s4 = 0., s5 = 0., s6 = 0., s7 = 0.;
+            long unsigned int i = begin;
+            for (; i + 8 <= end; i += 8) {
+                s0 += term (i);
+                s1 += term (i + 1);
+                s2 += term (i + 2);
+                s3 += term (i + 3);
+                s4 += term (i + 4);
+                s5 += term (i + 5);
+                s6 += term (i + 6);
+                s7 += term (i + 7);
+            }
+            for (; i < end; i++)
+                s0 += term (i);
+            return ((s0 + s1) + (s2 + s3)) + ((s4 + s5) + (s6 + s7));
+        }
+
+        /* попарное сложение: дерево зависит только от count */
+        __attribute__ ((optimize ("fp-contract=off")))
+        static double pairwise (const double* partial, long unsigned int count) {
+            if (count == 1)
+                return partial[0];
+            long unsigned int half = count / 2;
+            return pairwise (partial, half) + pairwise (partial + half, count - half);
+        }
+
+        template <class Term>
+        static double reproducible_sum (const Term& term, long unsigned int n) {
+            long unsigned int blocks = (n + block - 1) / block;
+            if (blocks <= 1)
+                return fixed_lanes (term, 0, n);
+            std::vector<double> partial (blocks);
+            parallel::for_range (blocks, block, [&term, &partial, n] (long unsigned int begin, long unsigned int end) {
+                for (long unsigned int k = begin; k < end; k++)
+                    partial[k] = fixed_lanes (term, k * block, std::min ((k + 1) * block, n));
+            });
+            return pairwise (partial.data(), blocks);
+        }
+
+        template <class Term>
+        static double fast_sum (const Term& term, long unsigned int n) {
+            if (parallel::get_workers() < 2 || n < parallel::grain)
+                return free_lanes (term, 0, n);
+            std::vector<std::pair<long unsigned int, double>> partial;
+            std::mutex lock;
+            parallel::for_range (n, 1UL, [&term, &partial, &lock] (long unsigned int begin, long unsigned int end) {
+                double value = free_lanes (term, begin, end);
+                std::lock_guard<std::mutex> guard (lock);
+                partial.push_back ({begin, value});
+            });
+            std::sort (partial.begin(), partial.end());
+            double result = 0.;
+            for (auto &item : partial)
+                result += item.second;
+            return result;
+        }
+
+
+        double dot (const double* a, const double* b, long unsigned int n,
+                    long unsigned int stride_a, long unsigned int stride_b) {
+            if (stride_a == 1 && stride_b == 1) {
+                contiguous term = {a, b};
+                if (get_mode() == reproducible)
+                    return reproducible_sum (term, n);
+                return fast_sum (term, n);
+            }
+            products term = {a, b, stride_a, stride_b};
+            if (get_mode() == reproducible)
+                return reproducible_sum (term, n);
+            return fast_sum (term, n);
+        }
+
+        double sum (const double* a, long unsigned int n) {
+            elements term = {a};
+            if (get_mode() == reproducible)
+                return reproducible_sum (term, n);
+            return fast_sum (term, n);
+        }
+    }
+}
+
+
+#endif /* REDUCE_CPP */
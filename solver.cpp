@@ -0,0 +1,635 @@
+#ifndef SOLVER_CPP
+#define SOLVER_CPP
+
+
+#include "solver.hpp"
+#include "parallel.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+
+namespace linear {
+    // доступ решателей к данным векторов
+    class _krylov {
+        public:
+            static const double* data (const vector& V) {
+                return V.m_data;
+            }
+
+            static double* data (vector& V) {
+                V.touch();
+                return V.m_data;
+            }
+
+            static long unsigned int length (const vector& V) {
+                return V.m_width * V.m_height;
+            }
+    };
+
+
+    // линейный оператор
+    double linear_operator::apply_dot (const double* x, double* y) const {
+        apply (x, y);
+        double result = 0.;
+        for (long unsigned int i = 0; i < get_size(); i++)
+            result += x[i] * y[i];
+        return result;
+    }
+
+
+    // плотный оператор
+    dense_operator::dense_operator (const matrix& A)
+    : m_matrix (A) {
+        if (A.m_width != A.m_height)
+            throw std::length_error ("Matrix is not square ");
+    }
+
+    long unsigned int dense_operator::get_size() const {
+        return m_matrix.m_width;
+    }
+
+    void dense_operator::apply (const double* x, double* y) const {
+        long unsigned int n = m_matrix.m_width;
+        const double* data = m_matrix.m_data;
+        parallel::for_range (n, n, [n, data, x, y] (long unsigned int begin, long unsigned int end) {
+            for (long unsigned int i = begin; i < end; i++) {
+                double sum = 0.;
+                for (long unsigned int j = 0; j < n; j++)
+                    sum += data[i * n + j] * x[j];
+                y[i] = sum;
+            }
+        });
+    }
+
+
+    // разреженный оператор
+    sparse::sparse (const matrix& A, double drop)
+    : m_size (A.m_width), m_start (A.m_width + 1, 0) {
+        if (A.m_width != A.m_height)
+            throw std::length_error ("Matrix is not square ");
+        for (long unsigned int i = 0; i < m_size; i++) {
+            for (long unsigned int j = 0; j < m_size; j++)
+                if (std::fabs (A.m_data[i * m_size + j]) > drop || (i == j && A.m_data[i * m_size + j] != 0.)) {
+                    m_column.push_back (j);
+                    m_value.push_back (A.m_data[i * m_size + j]);
+                }
+            m_start[i + 1] = m_column.size();
+        }
+    }
+
+    sparse::sparse (long unsigned int size, const std::vector<long unsigned int>& rows,
+                    const std::vector<long unsigned int>& cols, const std::vector<double>& values)
+    : m_size (size), m_start (size + 1, 0) {
+        if (size < 1)
+            throw std::invalid_argument ("Invalid matrix size ");
+        if (rows.size() != cols.size() || rows.size() != values.size())
+            throw std::length_error ("Invalid triplets ");
+        std::vector<long unsigned int> order (rows.size());
+        for (long unsigned int k = 0; k < order.size(); k++) {
+            if (rows[k] >= size || cols[k] >= size)
+                throw std::out_of_range ("Index is out of range ");
+            order[k] = k;
+        }
+        std::sort (order.begin(), order.end(), [&rows, &cols] (long unsigned int a, long unsigned int b) {
+            return (rows[a] != rows[b])? rows[a] < rows[b]: cols[a] < cols[b];
+        });
+        long unsigned int row = 0;
+        for (long unsigned int k = 0; k < order.size(); k++) {
+            long unsigned int i = rows[order[k]], j = cols[order[k]];
+            while (row < i)
+                m_start[++row] = m_column.size();
+            if (m_column.size() > m_start[i] && m_column.back() == j) {
+                m_value.back() += values[order[k]];
+                continue;
+            }
+            m_column.push_back (j);
+            m_value.push_back (values[order[k]]);
+        }
+        while (row < size)
+            m_start[++row] = m_column.size();
+    }
+
+    long unsigned int sparse::get_size() const {
+        return m_size;
+    }
+
+    long unsigned int sparse::get_nonzeros() const {
+        return m_value.size();
+    }
+
+    void sparse::apply (const double* x, double* y) const {
+        for (long unsigned int i = 0; i < m_size; i++) {
+            double sum = 0.;
+            for (long unsigned int k = m_start[i]; k < m_start[i + 1]; k++)
+                sum += m_value[k] * x[m_column[k]];
+            y[i] = sum;
+        }
+    }
+
+    double sparse::apply_dot (const double* x, double* y) const {
+        double result = 0.;
+        for (long unsigned int i = 0; i < m_size; i++) {
+            double sum = 0.;
+            for (long unsigned int k = m_start[i]; k < m_start[i + 1]; k++)
+                sum += m_value[k] * x[m_column[k]];
+            y[i] = sum;
+            result += x[i] * sum;
+        }
+        return result;
+    }
+
+
+    // оператор без матрицы
+    function_operator::function_operator (long unsigned int size, const std::function<void (const double*, double*)>& apply)
+    : m_size (size), m_apply (apply) {
+        if (size < 1)
+            throw std::invalid_argument ("Invalid matrix size ");
+    }
+
+    long unsigned int function_operator::get_size() const {
+        return m_size;
+    }
+
+    void function_operator::apply (const double* x, double* y) const {
+        m_apply (x, y);
+    }
+
+
+    // предобуславливатели
+    double preconditioner::apply_dot (const double* r, double* z, long unsigned int size) const {
+        apply (r, z, size);
+        double result = 0.;
+        for (long unsigned int i = 0; i < size; i++)
+            result += r[i] * z[i];
+        return result;
+    }
+
+    void identity::apply (const double* r, double* z, long unsigned int size) const {
+        for (long unsigned int i = 0; i < size; i++)
+            z[i] = r[i];
+    }
+
+    double identity::apply_dot (const double* r, double* z, long unsigned int size) const {
+        double result = 0.;
+        for (long unsigned int i = 0; i < size; i++) {
+            z[i] = r[i];
+            result += r[i] * r[i];
+        }
+        return result;
+    }
+
+    jacobi::jacobi (const matrix& A)
+    : m_inverse (A.m_width) {
+        if (A.m_width != A.m_height)
+            throw std::length_error ("Matrix is not square ");
+        for (long unsigned int i = 0; i < A.m_width; i++) {
+            double d = A.m_data[i * A.m_width + i];
+            if (d == 0.)
+                throw singular_error();
+            m_inverse[i] = 1. / d;
+        }
+    }
+
+    jacobi::jacobi (const sparse& A)
+    : m_inverse (A.m_size, 0.) {
+        for (long unsigned int i = 0; i < A.m_size; i++)
+            for (long unsigned int k = A.m_start[i]; k < A.m_start[i + 1]; k++)
+                if (A.m_column[k] == i && A.m_value[k] != 0.)
+                    m_inverse[i] = 1. / A.m_value[k];
+        for (long unsigned int i = 0; i < A.m_size; i++)
+            if (m_inverse[i] == 0.)
+                throw singular_error();
+    }
+
+    void jacobi::apply (const double* r, double* z, long unsigned int size) const {
+        if (size != m_inverse.size())
+            throw std::length_error ("Matrix's sizes are different ");
+        for (long unsigned int i = 0; i < size; i++)
+            z[i] = r[i] * m_inverse[i];
+    }
+
+    double jacobi::apply_dot (const double* r, double* z, long unsigned int size) const {
+        if (size != m_inverse.size())
+            throw std::length_error ("Matrix's sizes are different ");
+        double result = 0.;
+        for (long unsigned int i = 0; i < size; i++) {
+            z[i] = r[i] * m_inverse[i];
+            result += r[i] * z[i];
+        }
+        return result;
+    }
+
+    /* факторизация IKJ на шаблоне A, строки упорядочены по столбцам */
+    ilu0::ilu0 (const sparse& A)
+    : m_factor (A), m_diagonal (A.m_size) {
+        const long unsigned int none = A.m_value.size();
+        long unsigned int n = A.m_size;
+        std::vector<long unsigned int>& start = m_factor.m_start;
+        std::vector<long unsigned int>& column = m_factor.m_column;
+        std::vector<double>& value = m_factor.m_value;
+
+        for (long unsigned int i = 0; i < n; i++) {
+            m_diagonal[i] = none;
+            for (long unsigned int k = start[i]; k < start[i + 1]; k++)
+                if (column[k] == i)
+                    m_diagonal[i] = k;
+            if (m_diagonal[i] == none)
+                throw std::invalid_argument ("Missing diagonal element ");
+        }
+
+        std::vector<long unsigned int> position (n, none);
+        for (long unsigned int i = 1; i < n; i++) {
+            for (long unsigned int k = start[i]; k < start[i + 1]; k++)
+                position[column[k]] = k;
+            for (long unsigned int p = start[i]; p < start[i + 1] && column[p] < i; p++) {
+                long unsigned int k = column[p];
+                double pivot = value[m_diagonal[k]];
+                if (pivot == 0.)
+                    throw singular_error();
+                value[p] /= pivot;
+                for (long unsigned int q = m_diagonal[k] + 1; q < start[k + 1]; q++)
+                    if (position[column[q]] != none)
+                        value[position[column[q]]] -= value[p] * value[q];
+            }
+            for (long unsigned int k = start[i]; k < start[i + 1]; k++)
+                position[column[k]] = none;
+        }
+        for (long unsigned int i = 0; i < n; i++)
+            if (value[m_diagonal[i]] == 0.)
+                throw singular_error();
+    }
+
+    void ilu0::apply (const double* r, double* z, long unsigned int size) const {
+        if (size != m_factor.m_size)
+            throw std::length_error ("Matrix's sizes are different ");
+        const std::vector<long unsigned int>& start = m_factor.m_start;
+        const std::vector<long unsigned int>& column = m_factor.m_column;
+        const std::vector<double>& value = m_factor.m_value;
+        for (long unsigned int i = 0; i < size; i++) {
+            double sum = r[i];
+            for (long unsigned int k = start[i]; k < m_diagonal[i]; k++)
+                sum -= value[k] * z[column[k]];
+            z[i] = sum;
+        }
+        for (long unsigned int step = 0; step < size; step++) {
+            long unsigned int i = size - 1 - step;
+            double sum = z[i];
+            for (long unsigned int k = m_diagonal[i] + 1; k < start[i + 1]; k++)
+                sum -= value[k] * z[column[k]];
+            z[i] = sum / value[m_diagonal[i]];
+        }
+    }
+
+
+    // решатели
+    static double norm (const double* a, long unsigned int n) {
+        double result = 0.;
+        for (long unsigned int i = 0; i < n; i++)
+            result += a[i] * a[i];
+        return std::sqrt (result);
+    }
+
+    /* истинная невязка |b - A x| / |b| в конце решения */
+    static void finish (const linear_operator& A, const double* b, const double* x, double bnorm,
+                        solve_info& info, std::chrono::steady_clock::time_point start) {
+        long unsigned int n = A.get_size();
+        std::vector<double> r (n);
+        A.apply (x, r.data());
+        info.applies++;
+        for (long unsigned int i = 0; i < n; i++)
+            r[i] = b[i] - r[i];
+        info.residual = norm (r.data(), n) / bnorm;
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        info.seconds = elapsed.count();
+    }
+
+    /* r = b - A x, возвращает |r|^2 */
+    static double residual (const linear_operator& A, const double* b, const double* x, double* r, solve_info& info) {
+        long unsigned int n = A.get_size();
+        A.apply (x, r);
+        info.applies++;
+        double rr = 0.;
+        for (long unsigned int i = 0; i < n; i++) {
+            r[i] = b[i] - r[i];
+            rr += r[i] * r[i];
+        }
+        return rr;
+    }
+
+    static void check (const linear_operator& A, const vector& b, const vector& x) {
+        if (_krylov::length (b) != A.get_size() || _krylov::length (x) != A.get_size())
+            throw std::length_error ("Matrixs are not isomeric ");
+    }
+
+    static solve_info started() {
+        solve_info info;
+        info.iterations = 0;
+        info.applies = 0;
+        info.residual = 0.;
+        info.converged = false;
+        info.seconds = 0.;
+        return info;
+    }
+
+
+    /* сопряжённые градиенты: обновления x, r и |r|^2 одним проходом */
+    solve_info cg (const linear_operator& A, const vector& B, vector& X, const preconditioner& M,
+                   double tolerance, long unsigned int max_iterations) {
+        check (A, B, X);
+        auto start = std::chrono::steady_clock::now();
+        solve_info info = started();
+        long unsigned int n = A.get_size();
+        const double* b = _krylov::data (B);
+        double* x = _krylov::data (X);
+
+        double bnorm = norm (b, n);
+        if (bnorm == 0.) {
+            for (long unsigned int i = 0; i < n; i++)
+                x[i] = 0.;
+            info.converged = true;
+            return info;
+        }
+
+        std::vector<double> r (n), z (n), p (n), q (n);
+        double rr = residual (A, b, x, r.data(), info);
+        double rz = M.apply_dot (r.data(), z.data(), n);
+        p = z;
+        info.history.push_back (std::sqrt (rr) / bnorm);
+        info.converged = info.history.back() <= tolerance;
+
+        while (!info.converged && info.iterations < max_iterations) {
+            double pq = A.apply_dot (p.data(), q.data());
+            info.applies++;
+            if (pq == 0.)
+                break;
+            double alpha = rz / pq;
+            rr = 0.;
+            for (long unsigned int i = 0; i < n; i++) {
+                x[i] += alpha * p[i];
+                r[i] -= alpha * q[i];
+                rr += r[i] * r[i];
+            }
+            info.iterations++;
+            info.history.push_back (std::sqrt (rr) / bnorm);
+            if (info.history.back() <= tolerance) {
+                info.converged = true;
+                break;
+            }
+            double rz_next = M.apply_dot (r.data(), z.data(), n);
+            double beta = rz_next / rz;
+            rz = rz_next;
+            for (long unsigned int i = 0; i < n; i++)
+                p[i] = z[i] + beta * p[i];
+        }
+        finish (A, b, x, bnorm, info, start);
+        if (info.residual > tolerance)
+            info.converged = false;
+        return info;
+    }
+
+
+    /* GMRES (restart) с правым предобуславливанием: A M^-1 u = b, x = M^-1 u.
+       Модифицированный Грам-Шмидт: вычитание проекции на v[k] и скалярное
+       произведение с v[k + 1] выполняются одним проходом */
+    solve_info gmres (const linear_operator& A, const vector& B, vector& X, const preconditioner& M,
+                      double tolerance, long unsigned int max_iterations, long unsigned int restart) {
+        check (A, B, X);
+        if (restart < 1)
+            throw std::invalid_argument ("Invalid restart ");
+        auto start = std::chrono::steady_clock::now();
+        solve_info info = started();
+        long unsigned int n = A.get_size();
+        long unsigned int m = restart;
+        const double* b = _krylov::data (B);
+        double* x = _krylov::data (X);
+
+        double bnorm = norm (b, n);
+        if (bnorm == 0.) {
+            for (long unsigned int i = 0; i < n; i++)
+                x[i] = 0.;
+            info.converged = true;
+            return info;
+        }
+
+        std::vector<double> V ((m + 1) * n), H ((m + 1) * m), cs (m), sn (m), g (m + 1), y (m);
+        std::vector<double> w (n), z (n);
+
+        while (true) {
+            double beta = std::sqrt (residual (A, b, x, V.data(), info));
+            info.history.push_back (beta / bnorm);
+            if (info.history.back() <= tolerance) {
+                info.converged = true;
+                break;
+            }
+            if (info.iterations >= max_iterations)
+                break;
+            for (long unsigned int i = 0; i < n; i++)
+                V[i] /= beta;
+            for (long unsigned int k = 0; k <= m; k++)
+                g[k] = 0.;
+            g[0] = beta;
+
+            long unsigned int j = 0;
+            bool done = false;
+            while (j < m && info.iterations < max_iterations) {
+                const double* v = V.data() + j * n;
+                M.apply (v, z.data(), n);
+                A.apply (z.data(), w.data());
+                info.applies++;
+
+                // h[0][j] = (w, v0)
+                double h = 0.;
+                for (long unsigned int i = 0; i < n; i++)
+                    h += w[i] * V[i];
+                for (long unsigned int k = 0; k <= j; k++) {
+                    H[k * m + j] = h;
+                    const double* vk = V.data() + k * n;
+                    const double* vnext = V.data() + (k + 1) * n;
+                    double next = 0.;
+                    if (k < j)
+                        for (long unsigned int i = 0; i < n; i++) {
+                            w[i] -= h * vk[i];
+                            next += w[i] * vnext[i];
+                        }
+                    else
+                        for (long unsigned int i = 0; i < n; i++) {
+                            w[i] -= h * vk[i];
+                            next += w[i] * w[i];
+                        }
+                    h = next;
+                }
+                double wnorm = std::sqrt (h);
+                H[(j + 1) * m + j] = wnorm;
+                if (wnorm > 0.) {
+                    double* vnew = V.data() + (j + 1) * n;
+                    for (long unsigned int i = 0; i < n; i++)
+                        vnew[i] = w[i] / wnorm;
+                }
+
+                // вращения Гивенса
+                for (long unsigned int k = 0; k < j; k++) {
+                    double a = H[k * m + j], c = H[(k + 1) * m + j];
+                    H[k * m + j] = cs[k] * a + sn[k] * c;
+                    H[(k + 1) * m + j] = -sn[k] * a + cs[k] * c;
+                }
+                double a = H[j * m + j], c = H[(j + 1) * m + j];
+                double r = std::sqrt (a * a + c * c);
+                cs[j] = (r == 0.)? 1.: a / r;
+                sn[j] = (r == 0.)? 0.: c / r;
+                H[j * m + j] = r;
+                H[(j + 1) * m + j] = 0.;
+                g[j + 1] = -sn[j] * g[j];
+                g[j] = cs[j] * g[j];
+
+                j++;
+                info.iterations++;
+                info.history.push_back (std::fabs (g[j]) / bnorm);
+                if (info.history.back() <= tolerance || wnorm == 0.) {
+                    done = true;
+                    break;
+                }
+            }
+
+            // H y = g, x += M^-1 (V y)
+            for (long unsigned int step = 0; step < j; step++) {
+                long unsigned int k = j - 1 - step;
+                double sum = g[k];
+                for (long unsigned int l = k + 1; l < j; l++)
+                    sum -= H[k * m + l] * y[l];
+                y[k] = sum / H[k * m + k];
+            }
+            for (long unsigned int i = 0; i < n; i++) {
+                double sum = 0.;
+                for (long unsigned int k = 0; k < j; k++)
+                    sum += V[k * n + i] * y[k];
+                w[i] = sum;
+            }
+            M.apply (w.data(), z.data(), n);
+            for (long unsigned int i = 0; i < n; i++)
+                x[i] += z[i];
+            if (done) {
+                info.converged = true;
+                break;
+            }
+            if (info.iterations >= max_iterations)
+                break;
+        }
+        finish (A, b, x, bnorm, info, start);
+        if (info.residual > tolerance)
+            info.converged = false;
+        return info;
+    }
+
+
+    /* BiCGSTAB с правым предобуславливанием; обновления x, r и скалярные
+       произведения следующей итерации совмещены в общих проходах */
+    solve_info bicgstab (const linear_operator& A, const vector& B, vector& X, const preconditioner& M,
+                         double tolerance, long unsigned int max_iterations) {
+        check (A, B, X);
+        auto start = std::chrono::steady_clock::now();
+        solve_info info = started();
+        long unsigned int n = A.get_size();
+        const double* b = _krylov::data (B);
+        double* x = _krylov::data (X);
+
+        double bnorm = norm (b, n);
+        if (bnorm == 0.) {
+            for (long unsigned int i = 0; i < n; i++)
+                x[i] = 0.;
+            info.converged = true;
+            return info;
+        }
+
+        std::vector<double> r (n), shadow (n), p (n, 0.), v (n, 0.), phat (n), s (n), shat (n), t (n);
+        double rr = residual (A, b, x, r.data(), info);
+        shadow = r;
+        double rho = rr, alpha = 1., omega = 1., rho_prev = 1.;
+        info.history.push_back (std::sqrt (rr) / bnorm);
+        info.converged = info.history.back() <= tolerance;
+
+        while (!info.converged && info.iterations < max_iterations) {
+            if (rho == 0.)
+                break;
+            double beta = (rho / rho_prev) * (alpha / omega);
+            for (long unsigned int i = 0; i < n; i++)
+                p[i] = r[i] + beta * (p[i] - omega * v[i]);
+            M.apply (p.data(), phat.data(), n);
+            A.apply (phat.data(), v.data());
+            info.applies++;
+
+            double sv = 0.;
+            for (long unsigned int i = 0; i < n; i++)
+                sv += shadow[i] * v[i];
+            if (sv == 0.)
+                break;
+            alpha = rho / sv;
+
+            double ss = 0.;
+            for (long unsigned int i = 0; i < n; i++) {
+                s[i] = r[i] - alpha * v[i];
+                ss += s[i] * s[i];
+            }
+            info.iterations++;
+            if (std::sqrt (ss) / bnorm <= tolerance) {
+                for (long unsigned int i = 0; i < n; i++)
+                    x[i] += alpha * phat[i];
+                info.history.push_back (std::sqrt (ss) / bnorm);
+                info.converged = true;
+                break;
+            }
+
+            M.apply (s.data(), shat.data(), n);
+            A.apply (shat.data(), t.data());
+            info.applies++;
+            double ts = 0., tt = 0.;
+            for (long unsigned int i = 0; i < n; i++) {
+                ts += t[i] * s[i];
+                tt += t[i] * t[i];
+            }
+            if (tt == 0.)
+                break;
+            omega = ts / tt;
+
+            rho_prev = rho;
+            rho = 0.;
+            rr = 0.;
+            for (long unsigned int i = 0; i < n; i++) {
+                x[i] += alpha * phat[i] + omega * shat[i];
+                r[i] = s[i] - omega * t[i];
+                rr += r[i] * r[i];
+                rho += shadow[i] * r[i];
+            }
+            info.history.push_back (std::sqrt (rr) / bnorm);
+            if (info.history.back() <= tolerance)
+                info.converged = true;
+            if (omega == 0.)
+                break;
+        }
+        finish (A, b, x, bnorm, info, start);
+        if (info.residual > tolerance)
+            info.converged = false;
+        return info;
+    }
+
+
+    // без предобуславливания
+    solve_info cg (const linear_operator& A, const vector& b, vector& x,
+                   double tolerance, long unsigned int max_iterations) {
+        return cg (A, b, x, identity(), tolerance, max_iterations);
+    }
+
+    solve_info gmres (const linear_operator& A, const vector& b, vector& x,
+                      double tolerance, long unsigned int max_iterations, long unsigned int restart) {
+        return gmres (A, b, x, identity(), tolerance, max_iterations, restart);
+    }
+
+    solve_info bicgstab (const linear_operator& A, const vector& b, vector& x,
+                         double tolerance, long unsigned int max_iterations) {
+        return bicgstab (A, b, x, identity(), tolerance, max_iterations);
+    }
+}
+
+
+#endif /* SOLVER_CPP */
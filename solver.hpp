@@ -0,0 +1,142 @@
+#ifndef SOLVER_HPP
+#define SOLVER_HPP
+
+
+#include "matrix.hpp"
+#include "vector.hpp"
+#include <functional>
+#include <vector>
+
+
+namespace linear {
+    // линейный оператор y = A x над векторами длины size
+    class linear_operator {
+        public:
+            virtual ~linear_operator() {}
+
+            virtual long unsigned int get_size() const = 0;
+            virtual void apply (const double* x, double* y) const = 0;
+
+            // y = A x и (x, y) за один проход; по умолчанию - два прохода
+            virtual double apply_dot (const double* x, double* y) const;
+    };
+
+    /* плотная матрица как оператор, без копирования */
+    class dense_operator: public linear_operator {
+        private:
+            const matrix& m_matrix;
+
+        public:
+            explicit dense_operator (const matrix&);
+
+            long unsigned int get_size() const override;
+            void apply (const double* x, double* y) const override;
+    };
+
+    /* разреженная матрица в формате CSR */
+    class sparse: public linear_operator {
+        friend class ilu0;
+        friend class jacobi;
+
+        private:
+            long unsigned int m_size;
+            std::vector<long unsigned int> m_start; // начало строки, size + 1
+            std::vector<long unsigned int> m_column;
+            std::vector<double> m_value;
+
+        public:
+            explicit sparse (const matrix&, double drop = 0.); // элементы с |a| > drop
+            sparse (long unsigned int size, const std::vector<long unsigned int>& rows,
+                    const std::vector<long unsigned int>& cols, const std::vector<double>& values); // из троек, повторы суммируются
+
+            long unsigned int get_size() const override;
+            long unsigned int get_nonzeros() const;
+            void apply (const double* x, double* y) const override;
+            double apply_dot (const double* x, double* y) const override;
+    };
+
+    /* оператор без матрицы */
+    class function_operator: public linear_operator {
+        private:
+            long unsigned int m_size;
+            std::function<void (const double*, double*)> m_apply;
+
+        public:
+            function_operator (long unsigned int size, const std::function<void (const double*, double*)>& apply);
+
+            long unsigned int get_size() const override;
+            void apply (const double* x, double* y) const override;
+    };
+
+
+    // предобуславливатель z = M^-1 r
+    class preconditioner {
+        public:
+            virtual ~preconditioner() {}
+
+            virtual void apply (const double* r, double* z, long unsigned int size) const = 0;
+
+            // z = M^-1 r и (r, z) за один проход
+            virtual double apply_dot (const double* r, double* z, long unsigned int size) const;
+    };
+
+    class identity: public preconditioner {
+        public:
+            void apply (const double* r, double* z, long unsigned int size) const override;
+            double apply_dot (const double* r, double* z, long unsigned int size) const override;
+    };
+
+    class jacobi: public preconditioner {
+        private:
+            std::vector<double> m_inverse; // 1 / a[i][i]
+
+        public:
+            explicit jacobi (const matrix&);
+            explicit jacobi (const sparse&);
+
+            void apply (const double* r, double* z, long unsigned int size) const override;
+            double apply_dot (const double* r, double* z, long unsigned int size) const override;
+    };
+
+    /* неполное LU без заполнения: L и U на шаблоне A */
+    class ilu0: public preconditioner {
+        private:
+            sparse m_factor;
+            std::vector<long unsigned int> m_diagonal; // позиция a[i][i] в строке
+
+        public:
+            explicit ilu0 (const sparse&);
+
+            void apply (const double* r, double* z, long unsigned int size) const override;
+    };
+
+
+    // телеметрия решения
+    struct solve_info {
+        long unsigned int iterations;
+        long unsigned int applies;    // умножений на оператор
+        double residual;              // |b - A x| / |b|
+        bool converged;
+        double seconds;
+        std::vector<double> history;  // относительная невязка по итерациям
+    };
+
+    // x - начальное приближение и результат; b и x любой ориентации длины size
+    solve_info cg (const linear_operator&, const vector& b, vector& x, const preconditioner&,
+                   double tolerance = 1e-10, long unsigned int max_iterations = 1000);
+    solve_info gmres (const linear_operator&, const vector& b, vector& x, const preconditioner&,
+                      double tolerance = 1e-10, long unsigned int max_iterations = 1000, long unsigned int restart = 30);
+    solve_info bicgstab (const linear_operator&, const vector& b, vector& x, const preconditioner&,
+                         double tolerance = 1e-10, long unsigned int max_iterations = 1000);
+
+    // без предобуславливания
+    solve_info cg (const linear_operator&, const vector& b, vector& x,
+                   double tolerance = 1e-10, long unsigned int max_iterations = 1000);
+    solve_info gmres (const linear_operator&, const vector& b, vector& x,
+                      double tolerance = 1e-10, long unsigned int max_iterations = 1000, long unsigned int restart = 30);
+    solve_info bicgstab (const linear_operator&, const vector& b, vector& x,
+                         double tolerance = 1e-10, long unsigned int max_iterations = 1000);
+}
+
+
+#endif /* SOLVER_HPP */
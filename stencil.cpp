@@ -0,0 +1,456 @@
+#ifndef STENCIL_CPP
+#define STENCIL_CPP
+
+
+#include "stencil.hpp"
+#include "parallel.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+#ifdef __AVX512F__
+
+#include <immintrin.h>
+
+#endif /* AVX512F */
+
+
+namespace linear {
+    /* окно в разобранном виде и доступ к данным сетки */
+    class _grid {
+        public:
+            const double* weights;
+            const double* col;
+            const double* row;
+            long unsigned int width;
+            long unsigned int height;
+            long unsigned int top;
+            long unsigned int left;
+            bool separable;
+
+            explicit _grid (const stencil& K)
+            : weights (K.m_weights.data()), col (K.m_col.data()), row (K.m_row.data()),
+              width (K.m_width), height (K.m_height), top ((K.m_height - 1) / 2),
+              left ((K.m_width - 1) / 2), separable (K.m_separable) {}
+
+            static const double* data (const matrix& M) {
+                return M.m_data;
+            }
+
+            static double* data (matrix& M) {
+                M.touch();
+                return M.m_data;
+            }
+    };
+
+    // плитки: обычный проход, временные блоки, банк ядер
+    const long unsigned int tile_rows = 32;
+    const long unsigned int tile_cols = 512;
+    const long unsigned int block_rows = 64;
+    const long unsigned int block_cols = 256;
+    const long unsigned int bank_rows = 2;
+
+
+    /* индекс в сетке по правилу границы; -1 - нуль */
+    static long int locate (long int g, long int n, border policy) {
+        if (g >= 0 && g < n)
+            return g;
+        switch (policy) {
+            case clamp_border:
+                return (g < 0)? 0: n - 1;
+            case wrap_border:
+                return ((g % n) + n) % n;
+            default:
+                return -1;
+        }
+    }
+
+    /* окно pr x pc с левым верхним углом (r0, c0) в координатах сетки;
+       внутренняя часть строки копируется целиком, края - по правилу */
+    static void fill (double* panel, long unsigned int pr, long unsigned int pc, const double* src,
+                      long unsigned int H, long unsigned int W, long int r0, long int c0, border policy) {
+        long int width = pc;
+        long int inner_begin = std::min (std::max (-c0, 0L), width);
+        long int inner_end = std::max (std::min (long (W) - c0, width), inner_begin);
+        for (long unsigned int r = 0; r < pr; r++) {
+            double* p = panel + r * pc;
+            long int sr = locate (r0 + long (r), H, policy);
+            if (sr < 0) {
+                std::fill (p, p + pc, 0.);
+                continue;
+            }
+            const double* row = src + sr * W;
+            for (long int c = 0; c < inner_begin; c++) {
+                long int sc = locate (c0 + c, W, policy);
+                p[c] = (sc < 0)? 0.: row[sc];
+            }
+            if (inner_end > inner_begin)
+                std::memcpy (p + inner_begin, row + c0 + inner_begin, (inner_end - inner_begin) * sizeof (double));
+            for (long int c = inner_end; c < width; c++) {
+                long int sc = locate (c0 + c, W, policy);
+                p[c] = (sc < 0)? 0.: row[sc];
+            }
+        }
+    }
+
+    /* rows x cols выходов по окну (rows + h - 1) x (cols + w - 1).
+       Скользящее окно: на каждый вес один проход по отрезку строки со
+       сдвинутым началом, внутренний цикл векторизуется; нулевые веса
+       (крест разностной схемы) пропускаются. tmp - (rows + h - 1) x cols */
+    static void apply (double* __restrict out, long unsigned int ldo, const double* __restrict in, long unsigned int ldi,
+                       const _grid& K, long unsigned int rows, long unsigned int cols, double* __restrict tmp) {
+        long unsigned int h = K.height, w = K.width;
+        if (K.separable) {
+            for (long unsigned int r = 0; r < rows + h - 1; r++) {
+                double* t = tmp + r * cols;
+                const double* p = in + r * ldi;
+                for (long unsigned int j = 0; j < cols; j++)
+                    t[j] = 0.;
+                for (long unsigned int b = 0; b < w; b++) {
+                    double k = K.row[b];
+                    if (k != 0.)
+                        for (long unsigned int j = 0; j < cols; j++)
+                            t[j] += k * p[j + b];
+                }
+            }
+            for (long unsigned int i = 0; i < rows; i++) {
+                double* o = out + i * ldo;
+                for (long unsigned int j = 0; j < cols; j++)
+                    o[j] = 0.;
+                for (long unsigned int a = 0; a < h; a++) {
+                    double k = K.col[a];
+                    const double* t = tmp + (i + a) * cols;
+                    if (k != 0.)
+                        for (long unsigned int j = 0; j < cols; j++)
+                            o[j] += k * t[j];
+                }
+            }
+            return;
+        }
+        for (long unsigned int i = 0; i < rows; i++) {
+            double* o = out + i * ldo;
+            for (long unsigned int j = 0; j < cols; j++)
+                o[j] = 0.;
+            for (long unsigned int a = 0; a < h; a++)
+                for (long unsigned int b = 0; b < w; b++) {
+                    double k = K.weights[a * w + b];
+                    const double* p = in + (i + a) * ldi + b;
+                    if (k != 0.)
+                        for (long unsigned int j = 0; j < cols; j++)
+                            o[j] += k * p[j];
+                }
+        }
+    }
+
+    /* строки [first, last) результата плитками tile_rows x tile_cols */
+    static void sweep (const double* src, double* dst, long unsigned int H, long unsigned int W,
+                       const _grid& K, border policy, long unsigned int first, long unsigned int last) {
+        long unsigned int h = K.height, w = K.width;
+        std::vector<double> panel ((tile_rows + h - 1) * (tile_cols + w - 1));
+        std::vector<double> tmp (K.separable? (tile_rows + h - 1) * tile_cols: 0);
+        for (long unsigned int r0 = first; r0 < last; r0 += tile_rows) {
+            long unsigned int rows = std::min (tile_rows, last - r0);
+            for (long unsigned int c0 = 0; c0 < W; c0 += tile_cols) {
+                long unsigned int cols = std::min (tile_cols, W - c0), pc = cols + w - 1;
+                fill (panel.data(), rows + h - 1, pc, src, H, W, long (r0) - long (K.top), long (c0) - long (K.left), policy);
+                apply (dst + r0 * W + c0, W, panel.data(), pc, K, rows, cols, tmp.data());
+            }
+        }
+    }
+
+    /* ореол за краем сетки в области [rb, re) x [cb, ce) окна: сначала
+       столбцы строк внутри сетки, затем строки целиком (углы - из уже
+       исправленных строк). Только zero и clamp */
+    static void fix (double* A, long unsigned int pc, long int g0r, long int g0c, long int H, long int W,
+                     long int rb, long int re, long int cb, long int ce, border policy) {
+        bool zero = (policy == zero_border);
+        long int left_end = std::min (ce, std::max (cb, -g0c));
+        long int right_begin = std::max (cb, std::min (ce, W - g0c));
+        for (long int r = rb; r < re; r++) {
+            long int gr = g0r + r;
+            if (gr < 0 || gr >= H)
+                continue;
+            double* a = A + r * pc;
+            for (long int c = cb; c < left_end; c++)
+                a[c] = zero? 0.: a[-g0c];
+            for (long int c = right_begin; c < ce; c++)
+                a[c] = zero? 0.: a[W - 1 - g0c];
+        }
+        for (long int r = rb; r < re; r++) {
+            long int gr = g0r + r;
+            if (gr >= 0 && gr < H)
+                continue;
+            double* a = A + r * pc;
+            const double* source = A + (((gr < 0)? 0: H - 1) - g0r) * pc;
+            for (long int c = cb; c < ce; c++)
+                a[c] = zero? 0.: source[c];
+        }
+    }
+
+    /* depth шагов над плитками строк [first, last) по block_rows.
+       Плитка читается с ореолом depth * (h - 1), каждый шаг сужает верную
+       область на радиус окна; за краем сетки ореол обновляется по правилу */
+    static void block (const double* src, double* dst, long unsigned int H, long unsigned int W,
+                       const _grid& K, border policy, long unsigned int depth,
+                       long unsigned int first, long unsigned int last) {
+        long unsigned int h = K.height, w = K.width;
+        long unsigned int bottom = h - 1 - K.top, right = w - 1 - K.left;
+        long unsigned int size = (block_rows + depth * (h - 1)) * (block_cols + depth * (w - 1));
+        std::vector<double> A (size), B (size), tmp (K.separable? size: 0);
+        for (long unsigned int tile = first; tile < last; tile++) {
+            long unsigned int r0 = tile * block_rows, rows = std::min (block_rows, H - r0);
+            for (long unsigned int c0 = 0; c0 < W; c0 += block_cols) {
+                long unsigned int cols = std::min (block_cols, W - c0);
+                long unsigned int pr = rows + depth * (h - 1), pc = cols + depth * (w - 1);
+                long int g0r = long (r0) - long (depth * K.top), g0c = long (c0) - long (depth * K.left);
+                fill (A.data(), pr, pc, src, H, W, g0r, g0c, policy);
+                for (long unsigned int step = 1; step <= depth; step++) {
+                    long unsigned int rb = step * K.top, re = pr - step * bottom;
+                    long unsigned int cb = step * K.left, ce = pc - step * right;
+                    apply (B.data() + rb * pc + cb, pc, A.data() + (rb - K.top) * pc + (cb - K.left), pc,
+                           K, re - rb, ce - cb, tmp.data());
+                    fix (B.data(), pc, g0r, g0c, H, W, rb, re, cb, ce, policy);
+                    std::swap (A, B);
+                }
+                for (long unsigned int i = 0; i < rows; i++)
+                    std::memcpy (dst + (r0 + i) * W + c0, A.data() + (depth * K.top + i) * pc + depth * K.left,
+                                 cols * sizeof (double));
+            }
+        }
+    }
+
+    /* C (rows x cols) = A (rows x inner) X (inner x cols), остаток блоков 4 x 16 */
+    static void gemm_tail (double* __restrict C, const double* __restrict A, const double* __restrict X,
+                           long unsigned int inner, long unsigned int cols,
+                           long unsigned int n0, long unsigned int n1, long unsigned int j0, long unsigned int j1) {
+        for (long unsigned int n = n0; n < n1; n++) {
+            double* c = C + n * cols;
+            for (long unsigned int j = j0; j < j1; j++)
+                c[j] = 0.;
+            for (long unsigned int k = 0; k < inner; k++) {
+                double a = A[n * inner + k];
+                const double* x = X + k * cols;
+                for (long unsigned int j = j0; j < j1; j++)
+                    c[j] += a * x[j];
+            }
+        }
+    }
+
+#ifdef __AVX512F__
+    /* блок 4 x 16 результата в восьми регистрах на всю глубину:
+       две загрузки X на восемь fma, C пишется один раз */
+    static void gemm_panel (double* __restrict C, const double* __restrict A, const double* __restrict X,
+                            long unsigned int rows, long unsigned int inner, long unsigned int cols) {
+        long unsigned int full_rows = rows / 4 * 4, full_cols = cols / 16 * 16;
+        for (long unsigned int n = 0; n < full_rows; n += 4) {
+            const double* a = A + n * inner;
+            for (long unsigned int j = 0; j < full_cols; j += 16) {
+                __m512d c00 = _mm512_setzero_pd(), c01 = _mm512_setzero_pd();
+                __m512d c10 = _mm512_setzero_pd(), c11 = _mm512_setzero_pd();
+                __m512d c20 = _mm512_setzero_pd(), c21 = _mm512_setzero_pd();
+                __m512d c30 = _mm512_setzero_pd(), c31 = _mm512_setzero_pd();
+                for (long unsigned int k = 0; k < inner; k++) {
+                    const double* x = X + k * cols + j;
+                    __m512d x0 = _mm512_loadu_pd (x), x1 = _mm512_loadu_pd (x + 8);
+                    __m512d a0 = _mm512_set1_pd (a[k]), a1 = _mm512_set1_pd (a[inner + k]);
+                    __m512d a2 = _mm512_set1_pd (a[2 * inner + k]), a3 = _mm512_set1_pd (a[3 * inner + k]);
+                    c00 = _mm512_fmadd_pd (a0, x0, c00);
+                    c01 = _mm512_fmadd_pd (a0, x1, c01);
+                    c10 = _mm512_fmadd_pd (a1, x0, c10);
+                    c11 = _mm512_fmadd_pd (a1, x1, c11);
+                    c20 = _mm512_fmadd_pd (a2, x0, c20);
+                    c21 = _mm512_fmadd_pd (a2, x1, c21);
+                    c30 = _mm512_fmadd_pd (a3, x0, c30);
+                    c31 = _mm512_fmadd_pd (a3, x1, c31);
+                }
+                double* c = C + n * cols + j;
+                _mm512_storeu_pd (c, c00);
+                _mm512_storeu_pd (c + 8, c01);
+                _mm512_storeu_pd (c + cols, c10);
+                _mm512_storeu_pd (c + cols + 8, c11);
+                _mm512_storeu_pd (c + 2 * cols, c20);
+                _mm512_storeu_pd (c + 2 * cols + 8, c21);
+                _mm512_storeu_pd (c + 3 * cols, c30);
+                _mm512_storeu_pd (c + 3 * cols + 8, c31);
+            }
+        }
+        gemm_tail (C, A, X, inner, cols, 0, full_rows, full_cols, cols);
+        gemm_tail (C, A, X, inner, cols, full_rows, rows, 0, cols);
+    }
+#else  /* AVX512F */
+    static void gemm_panel (double* __restrict C, const double* __restrict A, const double* __restrict X,
+                            long unsigned int rows, long unsigned int inner, long unsigned int cols) {
+        gemm_tail (C, A, X, inner, cols, 0, rows, 0, cols);
+    }
+#endif /* AVX512F */
+
+
+    // окно
+    stencil::stencil (const matrix& weights)
+    : m_weights (_grid::data (weights), _grid::data (weights) + weights.get_width() * weights.get_height()),
+      m_width (weights.get_width()), m_height (weights.get_height()), m_separable (false) {
+        detect();
+    }
+
+    stencil::stencil (const vector& col, const vector& row)
+    : m_weights (), m_col (_grid::data (col), _grid::data (col) + col.get_width() * col.get_height()),
+      m_row (_grid::data (row), _grid::data (row) + row.get_width() * row.get_height()),
+      m_width (m_row.size()), m_height (m_col.size()), m_separable (true) {
+        for (long unsigned int a = 0; a < m_height; a++)
+            for (long unsigned int b = 0; b < m_width; b++)
+                m_weights.push_back (m_col[a] * m_row[b]);
+    }
+
+    /* K = col row^T по строке и столбцу наибольшего веса, проверка с допуском */
+    void stencil::detect() {
+        long unsigned int h = m_height, w = m_width, pivot = 0;
+        for (long unsigned int k = 1; k < h * w; k++)
+            if (std::fabs (m_weights[k]) > std::fabs (m_weights[pivot]))
+                pivot = k;
+        double largest = std::fabs (m_weights[pivot]);
+        if (h < 2 || w < 2 || largest == 0.)
+            return;
+
+        long unsigned int p = pivot / w, q = pivot % w;
+        std::vector<double> col (h), row (w);
+        for (long unsigned int a = 0; a < h; a++)
+            col[a] = m_weights[a * w + q];
+        for (long unsigned int b = 0; b < w; b++)
+            row[b] = m_weights[p * w + b] / m_weights[pivot];
+        for (long unsigned int a = 0; a < h; a++)
+            for (long unsigned int b = 0; b < w; b++)
+                if (std::fabs (m_weights[a * w + b] - col[a] * row[b]) > 1e-12 * largest)
+                    return;
+        m_col = col;
+        m_row = row;
+        m_separable = true;
+    }
+
+    long unsigned int stencil::get_width() const {
+        return m_width;
+    }
+
+    long unsigned int stencil::get_height() const {
+        return m_height;
+    }
+
+    bool stencil::is_separable() const {
+        return m_separable;
+    }
+
+    matrix stencil::get_weights() const {
+        matrix result (m_width, m_height);
+        std::copy (m_weights.begin(), m_weights.end(), _grid::data (result));
+        return result;
+    }
+
+
+    // свёртка
+    matrix convolve (const matrix& M, const stencil& S, border policy) {
+        matrix result (M.get_width(), M.get_height());
+        convolve (M, S, result, policy);
+        return result;
+    }
+
+    void convolve (const matrix& M, const stencil& S, matrix& result, border policy) {
+        long unsigned int H = M.get_height(), W = M.get_width();
+        if (result.get_height() != H || result.get_width() != W)
+            throw std::length_error ("Matrix's sizes are different ");
+        // буферы сравниваются по адресам: внешний буфер result может лежать над M
+        const double* src = _grid::data (M);
+        const double* out = _grid::data (static_cast<const matrix&> (result));
+        if (H * W > 0 && out < src + H * W && src < out + H * W)
+            throw std::invalid_argument ("Result aliases operand ");
+        _grid K (S);
+        double* dst = _grid::data (result);
+        parallel::for_range (H, W * K.width * K.height, [&] (long unsigned int first, long unsigned int last) {
+            sweep (src, dst, H, W, K, policy, first, last);
+        });
+    }
+
+    /* малые окна и одиночные ядра дешевле скользящим окном: im2col здесь
+       окупается только повторным чтением столбцов патчей на каждое ядро */
+    std::vector<matrix> convolve (const matrix& M, const std::vector<stencil>& bank, border policy) {
+        long unsigned int H = M.get_height(), W = M.get_width();
+        std::vector<matrix> result;
+        if (bank.empty())
+            return result;
+        long unsigned int h = bank[0].get_height(), w = bank[0].get_width(), kk = h * w, nk = bank.size();
+        for (auto &current : bank)
+            if (current.get_height() != h || current.get_width() != w)
+                throw std::length_error ("Matrix's sizes are different ");
+        for (long unsigned int n = 0; n < nk; n++)
+            result.emplace_back (W, H);
+        if (nk < 4 || kk < 9) {
+            for (long unsigned int n = 0; n < nk; n++)
+                convolve (M, bank[n], result[n], policy);
+            return result;
+        }
+
+        std::vector<double> weights;
+        std::vector<double*> outputs;
+        for (long unsigned int n = 0; n < nk; n++) {
+            _grid K (bank[n]);
+            weights.insert (weights.end(), K.weights, K.weights + kk);
+            outputs.push_back (_grid::data (result[n]));
+        }
+        const double* src = _grid::data (M);
+        long unsigned int top = (h - 1) / 2, left = (w - 1) / 2;
+        parallel::for_range (H, W * kk * nk, [&] (long unsigned int first, long unsigned int last) {
+            std::vector<double> panel ((bank_rows + h - 1) * (block_cols + w - 1));
+            std::vector<double> patches (kk * bank_rows * block_cols), product (nk * bank_rows * block_cols);
+            for (long unsigned int r0 = first; r0 < last; r0 += bank_rows) {
+                long unsigned int rows = std::min (bank_rows, last - r0);
+                for (long unsigned int c0 = 0; c0 < W; c0 += block_cols) {
+                    long unsigned int cols = std::min (block_cols, W - c0), pc = cols + w - 1, count = rows * cols;
+                    fill (panel.data(), rows + h - 1, pc, src, H, W, long (r0) - long (top), long (c0) - long (left), policy);
+                    // im2col: строка патчей на вес, столбец на точку плитки
+                    for (long unsigned int a = 0; a < h; a++)
+                        for (long unsigned int b = 0; b < w; b++)
+                            for (long unsigned int i = 0; i < rows; i++)
+                                std::memcpy (patches.data() + (a * w + b) * count + i * cols,
+                                             panel.data() + (i + a) * pc + b, cols * sizeof (double));
+                    gemm_panel (product.data(), weights.data(), patches.data(), nk, kk, count);
+                    for (long unsigned int n = 0; n < nk; n++)
+                        for (long unsigned int i = 0; i < rows; i++)
+                            std::memcpy (outputs[n] + (r0 + i) * W + c0, product.data() + n * count + i * cols,
+                                         cols * sizeof (double));
+                }
+            }
+        });
+        return result;
+    }
+
+    matrix iterate (const matrix& M, const stencil& S, long unsigned int steps, border policy) {
+        long unsigned int H = M.get_height(), W = M.get_width();
+        matrix current (M), next (W, H);
+        double* source = _grid::data (current);
+        double* target = _grid::data (next);
+        _grid K (S);
+        // ореол не больше четверти плитки, в блоке не больше 8 шагов
+        long unsigned int radius = std::max (std::max (K.height, K.width) - 1, 1UL);
+        long unsigned int depth = (policy == wrap_border)? 1: std::min (std::max (block_rows / (4 * radius), 1UL), 8UL);
+        long unsigned int tiles = (H + block_rows - 1) / block_rows;
+
+        for (long unsigned int done = 0; done < steps; ) {
+            long unsigned int count = std::min (depth, steps - done);
+            if (policy == wrap_border || count == 1)
+                parallel::for_range (H, W * K.width * K.height, [&] (long unsigned int first, long unsigned int last) {
+                    sweep (source, target, H, W, K, policy, first, last);
+                });
+            else
+                parallel::for_range (tiles, block_rows * W * K.width * K.height * count, [&] (long unsigned int first, long unsigned int last) {
+                    block (source, target, H, W, K, policy, count, first, last);
+                });
+            std::swap (source, target);
+            done += count;
+        }
+        if (source == _grid::data (current))
+            return current;
+        return next;
+    }
+}
+
+
+#endif /* STENCIL_CPP */
@@ -0,0 +1,60 @@
+#ifndef STENCIL_HPP
+#define STENCIL_HPP
+
+
+#include "matrix.hpp"
+#include "vector.hpp"
+#include <vector>
+
+
+namespace linear {
+    // значения за границей сетки
+    enum border {
+        zero_border,  // нули
+        clamp_border, // ближайший край
+        wrap_border   // периодически
+    };
+
+    /* окно весов height x width с якорем ((height - 1) / 2, (width - 1) / 2).
+       Ядро не отражается, как в разностных схемах и фильтрах изображений:
+       out[i][j] = sum K[a][b] M[i + a - top][j + b - left].
+       Ранг 1 распознаётся при построении, тогда проход идёт по строкам и столбцам */
+    class stencil {
+        friend class _grid;
+
+        private:
+            std::vector<double> m_weights; // по строкам
+            std::vector<double> m_col;     // K = col row^T при отделимости
+            std::vector<double> m_row;
+            long unsigned int m_width;
+            long unsigned int m_height;
+            bool m_separable;
+
+            void detect();
+
+        public:
+            explicit stencil (const matrix& weights);
+            stencil (const vector& col, const vector& row); // отделимое col row^T
+
+            // вспомогательные
+            long unsigned int get_width() const;
+            long unsigned int get_height() const;
+            bool is_separable() const;
+            matrix get_weights() const;
+    };
+
+    // сетка обходится плитками по потокам; результат той же формы
+    matrix convolve (const matrix&, const stencil&, border policy = zero_border);
+    void convolve (const matrix&, const stencil&, matrix& result, border policy = zero_border);
+
+    // банк ядер одного размера: im2col по плитке и одно умножение на матрицу весов
+    std::vector<matrix> convolve (const matrix&, const std::vector<stencil>&, border policy = zero_border);
+
+    /* steps применений подряд. Для zero и clamp шаги сливаются во временные
+       блоки: плитка с ореолом проходит несколько шагов в кэше, сетка
+       читается раз на блок. wrap требует всей сетки и идёт по шагу */
+    matrix iterate (const matrix&, const stencil&, long unsigned int steps, border policy = zero_border);
+}
+
+
+#endif /* STENCIL_HPP */
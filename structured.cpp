@@ -0,0 +1,1147 @@
+#ifndef STRUCTURED_CPP
+#define STRUCTURED_CPP
+
+
+#include "structured.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <utility>
+#include <cmath>
+
+
+namespace linear {
+    /* вектор заданной формы: строка { n * 1 } или столбец { 1 * n } */
+    static vector shaped (long unsigned int width, long unsigned int height) {
+        vector result (width * height);
+        if (height > 1)
+            result.to_transpose();
+        return result;
+    }
+
+
+    /// Storage of length elements for a { size * size } structured matrix
+    _storage::_storage (long unsigned int size, long unsigned int length, double def)
+    : m_size (size), m_length (length) {
+        if (size < 1)
+            throw std::invalid_argument ("Invalid matrix size ");
+        m_data = new double[length];
+        for (long unsigned int i = 0; i < length; i++)
+            m_data[i] = def;
+    }
+
+    _storage::_storage (const _storage& refer)
+    : m_size (refer.m_size), m_length (refer.m_length) {
+        m_data = new double[m_length];
+        for (long unsigned int i = 0; i < m_length; i++)
+            m_data[i] = refer.m_data[i];
+    }
+
+    _storage::_storage (_storage&& refer)
+    : m_data (refer.m_data), m_size (refer.m_size), m_length (refer.m_length) {
+        refer.m_data = nullptr;
+        refer.m_size = 0;
+        refer.m_length = 0;
+    }
+
+    _storage::~_storage() {
+        delete[] m_data;
+    }
+
+    _storage& _storage::operator= (const _storage& refer) {
+        if (&refer == this)
+            return *this;
+        if (m_length != refer.m_length) {
+            delete[] m_data;
+            m_length = refer.m_length;
+            m_data = new double[m_length];
+        }
+        m_size = refer.m_size;
+        for (long unsigned int i = 0; i < m_length; i++)
+            m_data[i] = refer.m_data[i];
+        return *this;
+    }
+
+    _storage& _storage::operator= (_storage&& refer) {
+        if (&refer == this)
+            return *this;
+        delete[] m_data;
+        m_data = refer.m_data;
+        m_size = refer.m_size;
+        m_length = refer.m_length;
+        refer.m_data = nullptr;
+        refer.m_size = 0;
+        refer.m_length = 0;
+        return *this;
+    }
+
+    void _storage::scale (double B) {
+        for (long unsigned int i = 0; i < m_length; i++)
+            m_data[i] *= B;
+    }
+
+    void _storage::add (const _storage& B) {
+        if (m_size != B.m_size || m_length != B.m_length)
+            throw std::length_error ("Matrix's sizes are different ");
+        for (long unsigned int i = 0; i < m_length; i++)
+            m_data[i] += B.m_data[i];
+    }
+
+    long unsigned int _storage::get_size() const {
+        return m_size;
+    }
+
+
+    // диагональная матрица
+    diagonal::diagonal (long unsigned int size, double def)
+    : _storage (size, size, def) {}
+
+    diagonal::diagonal (const matrix& refer)
+    : _storage (refer.m_width, refer.m_width, 0.) {
+        if (refer.m_width != refer.m_height)
+            throw std::length_error ("Matrix is not square ");
+        for (long unsigned int i = 0; i < m_size; i++)
+            m_data[i] = refer.m_data[i * m_size + i];
+    }
+
+    diagonal::diagonal (const vector& refer)
+    : _storage (refer.m_width * refer.m_height, refer.m_width * refer.m_height, 0.) {
+        for (long unsigned int i = 0; i < m_size; i++)
+            m_data[i] = refer.m_data[i];
+    }
+
+    diagonal::diagonal (const std::initializer_list<double> &list)
+    : _storage (list.size(), list.size(), 0.) {
+        long unsigned int count = 0;
+        for (auto &element : list)
+            m_data[count++] = element;
+    }
+
+    matrix diagonal::get_matrix() const {
+        matrix result (m_size, 0.);
+        for (long unsigned int i = 0; i < m_size; i++)
+            result.m_data[i * m_size + i] = m_data[i];
+        return result;
+    }
+
+    diagonal diagonal::get_transpose() const {
+        return diagonal (*this);
+    }
+
+    diagonal& diagonal::to_transpose() {
+        return *this;
+    }
+
+    double diagonal::operator() (long unsigned int row, long unsigned int col) const {
+        if (row >= m_size || col >= m_size)
+            throw std::out_of_range ("Index is out of range ");
+        return (row == col)? m_data[row]: 0.;
+    }
+
+    double& diagonal::operator[] (long unsigned int index) {
+        if (index >= m_size)
+            throw std::out_of_range ("Index is out of range ");
+        return m_data[index];
+    }
+
+    double diagonal::operator[] (long unsigned int index) const {
+        if (index >= m_size)
+            throw std::out_of_range ("Index is out of range ");
+        return m_data[index];
+    }
+
+    matrix diagonal::mul_left (const matrix& M) const {
+        matrix result (M.m_width, M.m_height);
+        mul_left (M, result);
+        return result;
+    }
+
+    void diagonal::mul_left (const matrix& M, matrix& result) const {
+        if (M.m_height != m_size)
+            throw std::length_error ("Matrixs are not isomeric ");
+        if (result.m_height != m_size || result.m_width != M.m_width)
+            throw std::length_error ("Matrix's sizes are different ");
+        result.touch();
+        for (long unsigned int i = 0; i < m_size; i++)
+            for (long unsigned int j = 0; j < M.m_width; j++)
+                result.m_data[i * M.m_width + j] = m_data[i] * M.m_data[i * M.m_width + j];
+    }
+
+    matrix diagonal::mul_right (const matrix& M) const {
+        matrix result (M.m_width, M.m_height);
+        mul_right (M, result);
+        return result;
+    }
+
+    void diagonal::mul_right (const matrix& M, matrix& result) const {
+        if (M.m_width != m_size)
+            throw std::length_error ("Matrixs are not isomeric ");
+        if (result.m_width != m_size || result.m_height != M.m_height)
+            throw std::length_error ("Matrix's sizes are different ");
+        result.touch();
+        for (long unsigned int r = 0; r < M.m_height; r++)
+            for (long unsigned int j = 0; j < m_size; j++)
+                result.m_data[r * m_size + j] = M.m_data[r * m_size + j] * m_data[j];
+    }
+
+    matrix diagonal::add_to (const matrix& M) const {
+        matrix result (M);
+        add_to (result, 1.);
+        return result;
+    }
+
+    void diagonal::add_to (matrix& M, double alpha) const {
+        if (M.m_width != m_size || M.m_height != m_size)
+            throw std::length_error ("Matrix's sizes are different ");
+        M.touch();
+        for (long unsigned int i = 0; i < m_size; i++)
+            M.m_data[i * m_size + i] += alpha * m_data[i];
+    }
+
+    vector diagonal::solve (const vector& b) const {
+        if (b.m_width * b.m_height != m_size)
+            throw std::length_error ("Matrixs are not isomeric ");
+        vector x (b);
+        for (long unsigned int i = 0; i < m_size; i++) {
+            if (m_data[i] == 0.)
+                throw singular_error();
+            x.m_data[i] /= m_data[i];
+        }
+        return x;
+    }
+
+    matrix diagonal::solve (const matrix& B) const {
+        if (B.m_height != m_size)
+            throw std::length_error ("Matrixs are not isomeric ");
+        matrix X (B);
+        for (long unsigned int i = 0; i < m_size; i++) {
+            if (m_data[i] == 0.)
+                throw singular_error();
+            for (long unsigned int j = 0; j < B.m_width; j++)
+                X.m_data[i * B.m_width + j] /= m_data[i];
+        }
+        return X;
+    }
+
+    diagonal& diagonal::operator+= (const diagonal& B) {
+        add (B);
+        return *this;
+    }
+
+    diagonal& diagonal::operator-= (const diagonal& B) {
+        add (B * -1.);
+        return *this;
+    }
+
+    diagonal& diagonal::operator*= (const diagonal& B) {
+        if (m_size != B.m_size)
+            throw std::length_error ("Matrixs are not isomeric ");
+        for (long unsigned int i = 0; i < m_size; i++)
+            m_data[i] *= B.m_data[i];
+        return *this;
+    }
+
+    diagonal& diagonal::operator*= (double B) {
+        scale (B);
+        return *this;
+    }
+
+
+    // треугольная матрица
+    triangular::triangular (long unsigned int size, bool upper, double def)
+    : _storage (size, size * (size + 1) / 2, def), m_upper (upper) {}
+
+    triangular::triangular (const matrix& refer, bool upper)
+    : _storage (refer.m_width, refer.m_width * (refer.m_width + 1) / 2, 0.), m_upper (upper) {
+        if (refer.m_width != refer.m_height)
+            throw std::length_error ("Matrix is not square ");
+        for (long unsigned int i = 0; i < m_size; i++)
+            for (long unsigned int j = first (i); j < last (i); j++)
+                m_data[offset (i, j)] = refer.m_data[i * m_size + j];
+    }
+
+    long unsigned int triangular::offset (long unsigned int row, long unsigned int col) const {
+        if (m_upper)
+            return row * (2 * m_size - row + 1) / 2 + (col - row);
+        return row * (row + 1) / 2 + col;
+    }
+
+    long unsigned int triangular::first (long unsigned int row) const {
+        return m_upper? row: 0;
+    }
+
+    long unsigned int triangular::last (long unsigned int row) const {
+        return m_upper? m_size: row + 1;
+    }
+
+    bool triangular::is_upper() const {
+        return m_upper;
+    }
+
+    matrix triangular::get_matrix() const {
+        matrix result (m_size, 0.);
+        for (long unsigned int i = 0; i < m_size; i++)
+            for (long unsigned int j = first (i); j < last (i); j++)
+                result.m_data[i * m_size + j] = m_data[offset (i, j)];
+        return result;
+    }
+
+    triangular triangular::get_transpose() const {
+        return triangular (*this).to_transpose();
+    }
+
+    triangular& triangular::to_transpose() {
+        triangular result (m_size, !m_upper);
+        for (long unsigned int i = 0; i < m_size; i++)
+            for (long unsigned int j = first (i); j < last (i); j++)
+                result.m_data[result.offset (j, i)] = m_data[offset (i, j)];
+        *this = std::move (result);
+        return *this;
+    }
+
+    double triangular::operator() (long unsigned int row, long unsigned int col) const {
+        if (row >= m_size || col >= m_size)
+            throw std::out_of_range ("Index is out of range ");
+        if (col < first (row) || col >= last (row))
+            return 0.;
+        return m_data[offset (row, col)];
+    }
+
+    double& triangular::at (long unsigned int row, long unsigned int col) {
+        if (row >= m_size || col < first (row) || col >= last (row))
+            throw std::out_of_range ("Index is out of range ");
+        return m_data[offset (row, col)];
+    }
+
+    matrix triangular::mul_left (const matrix& M) const {
+        matrix result (M.m_width, M.m_height);
+        mul_left (M, result);
+        return result;
+    }
+
+    /* строка i результата: сумма строк M с весами хранимой строки i */
+    void triangular::mul_left (const matrix& M, matrix& result) const {
+        if (M.m_height != m_size)
+            throw std::length_error ("Matrixs are not isomeric ");
+        if (result.m_height != m_size || result.m_width != M.m_width)
+            throw std::length_error ("Matrix's sizes are different ");
+        result.touch();
+        long unsigned int width = M.m_width;
+        for (long unsigned int i = 0; i < m_size; i++) {
+            double* out = result.m_data + i * width;
+            for (long unsigned int j = 0; j < width; j++)
+                out[j] = 0.;
+            for (long unsigned int k = first (i); k < last (i); k++) {
+                double t = m_data[offset (i, k)];
+                const double* in = M.m_data + k * width;
+                for (long unsigned int j = 0; j < width; j++)
+                    out[j] += t * in[j];
+            }
+        }
+    }
+
+    matrix triangular::mul_right (const matrix& M) const {
+        matrix result (M.m_width, M.m_height);
+        mul_right (M, result);
+        return result;
+    }
+
+    /* строка r результата: сумма хранимых строк k с весами M[r][k] */
+    void triangular::mul_right (const matrix& M, matrix& result) const {
+        if (M.m_width != m_size)
+            throw std::length_error ("Matrixs are not isomeric ");
+        if (result.m_width != m_size || result.m_height != M.m_height)
+            throw std::length_error ("Matrix's sizes are different ");
+        result.touch();
+        for (long unsigned int r = 0; r < M.m_height; r++) {
+            double* out = result.m_data + r * m_size;
+            for (long unsigned int j = 0; j < m_size; j++)
+                out[j] = 0.;
+            for (long unsigned int k = 0; k < m_size; k++) {
+                double m = M.m_data[r * m_size + k];
+                const double* row = m_data + offset (k, first (k));
+                for (long unsigned int j = first (k); j < last (k); j++)
+                    out[j] += m * row[j - first (k)];
+            }
+        }
+    }
+
+    matrix triangular::add_to (const matrix& M) const {
+        matrix result (M);
+        add_to (result, 1.);
+        return result;
+    }
+
+    void triangular::add_to (matrix& M, double alpha) const {
+        if (M.m_width != m_size || M.m_height != m_size)
+            throw std::length_error ("Matrix's sizes are different ");
+        M.touch();
+        for (long unsigned int i = 0; i < m_size; i++)
+            for (long unsigned int j = first (i); j < last (i); j++)
+                M.m_data[i * m_size + j] += alpha * m_data[offset (i, j)];
+    }
+
+    vector triangular::solve (const vector& b) const {
+        if (b.m_width * b.m_height != m_size)
+            throw std::length_error ("Matrixs are not isomeric ");
+        vector x (b);
+        solve (x.m_data, 1UL);
+        return x;
+    }
+
+    matrix triangular::solve (const matrix& B) const {
+        if (B.m_height != m_size)
+            throw std::length_error ("Matrixs are not isomeric ");
+        matrix X (B);
+        solve (X.m_data, B.m_width);
+        return X;
+    }
+
+    /* подстановка по строкам: X[i] = (B[i] - sum T[i][j] X[j]) / T[i][i] */
+    void triangular::solve (double* X, long unsigned int width) const {
+        for (long unsigned int step = 0; step < m_size; step++) {
+            long unsigned int i = m_upper? m_size - 1 - step: step;
+            double* out = X + i * width;
+            for (long unsigned int k = first (i); k < last (i); k++) {
+                if (k == i)
+                    continue;
+                double t = m_data[offset (i, k)];
+                const double* in = X + k * width;
+                for (long unsigned int j = 0; j < width; j++)
+                    out[j] -= t * in[j];
+            }
+            double pivot = m_data[offset (i, i)];
+            if (pivot == 0.)
+                throw singular_error();
+            for (long unsigned int j = 0; j < width; j++)
+                out[j] /= pivot;
+        }
+    }
+
+    triangular& triangular::operator+= (const triangular& B) {
+        if (m_upper != B.m_upper)
+            throw std::invalid_argument ("Triangles are different ");
+        add (B);
+        return *this;
+    }
+
+    triangular& triangular::operator-= (const triangular& B) {
+        if (m_upper != B.m_upper)
+            throw std::invalid_argument ("Triangles are different ");
+        add (B * -1.);
+        return *this;
+    }
+
+    /* произведение треугольных одного вида остаётся в том же треугольнике */
+    triangular& triangular::operator*= (const triangular& B) {
+        if (m_size != B.m_size)
+            throw std::length_error ("Matrixs are not isomeric ");
+        if (m_upper != B.m_upper)
+            throw std::invalid_argument ("Triangles are different ");
+        triangular result (m_size, m_upper);
+        for (long unsigned int i = 0; i < m_size; i++)
+            for (long unsigned int k = first (i); k < last (i); k++) {
+                double a = m_data[offset (i, k)];
+                for (long unsigned int j = B.first (k); j < B.last (k); j++)
+                    result.m_data[result.offset (i, j)] += a * B.m_data[B.offset (k, j)];
+            }
+        *this = std::move (result);
+        return *this;
+    }
+
+    triangular& triangular::operator*= (double B) {
+        scale (B);
+        return *this;
+    }
+
+
+    // симметричная матрица
+    symmetric::symmetric (long unsigned int size, double def)
+    : _storage (size, size * (size + 1) / 2, def) {}
+
+    symmetric::symmetric (const matrix& refer)
+    : _storage (refer.m_width, refer.m_width * (refer.m_width + 1) / 2, 0.) {
+        if (refer.m_width != refer.m_height)
+            throw std::length_error ("Matrix is not square ");
+        for (long unsigned int i = 0; i < m_size; i++)
+            for (long unsigned int j = 0; j <= i; j++)
+                m_data[offset (i, j)] = refer.m_data[i * m_size + j];
+    }
+
+    long unsigned int symmetric::offset (long unsigned int row, long unsigned int col) const {
+        if (row < col)
+            std::swap (row, col);
+        return row * (row + 1) / 2 + col;
+    }
+
+    matrix symmetric::get_matrix() const {
+        matrix result (m_size, 0.);
+        for (long unsigned int i = 0; i < m_size; i++)
+            for (long unsigned int j = 0; j <= i; j++) {
+                result.m_data[i * m_size + j] = m_data[offset (i, j)];
+                result.m_data[j * m_size + i] = m_data[offset (i, j)];
+            }
+        return result;
+    }
+
+    symmetric symmetric::get_transpose() const {
+        return symmetric (*this);
+    }
+
+    symmetric& symmetric::to_transpose() {
+        return *this;
+    }
+
+    double symmetric::operator() (long unsigned int row, long unsigned int col) const {
+        if (row >= m_size || col >= m_size)
+            throw std::out_of_range ("Index is out of range ");
+        return m_data[offset (row, col)];
+    }
+
+    double& symmetric::at (long unsigned int row, long unsigned int col) {
+        if (row >= m_size || col >= m_size)
+            throw std::out_of_range ("Index is out of range ");
+        return m_data[offset (row, col)];
+    }
+
+    matrix symmetric::mul_left (const matrix& M) const {
+        matrix result (M.m_width, M.m_height);
+        mul_left (M, result);
+        return result;
+    }
+
+    /* каждый хранимый элемент s[i][k] даёт вклад в строки i и k */
+    void symmetric::mul_left (const matrix& M, matrix& result) const {
+        if (M.m_height != m_size)
+            throw std::length_error ("Matrixs are not isomeric ");
+        if (result.m_height != m_size || result.m_width != M.m_width)
+            throw std::length_error ("Matrix's sizes are different ");
+        result.touch();
+        long unsigned int width = M.m_width;
+        for (long unsigned int i = 0; i < m_size * width; i++)
+            result.m_data[i] = 0.;
+        for (long unsigned int i = 0; i < m_size; i++)
+            for (long unsigned int k = 0; k <= i; k++) {
+                double s = m_data[offset (i, k)];
+                double* out_i = result.m_data + i * width;
+                const double* in_k = M.m_data + k * width;
+                for (long unsigned int j = 0; j < width; j++)
+                    out_i[j] += s * in_k[j];
+                if (k == i)
+                    continue;
+                double* out_k = result.m_data + k * width;
+                const double* in_i = M.m_data + i * width;
+                for (long unsigned int j = 0; j < width; j++)
+                    out_k[j] += s * in_i[j];
+            }
+    }
+
+    matrix symmetric::mul_right (const matrix& M) const {
+        matrix result (M.m_width, M.m_height);
+        mul_right (M, result);
+        return result;
+    }
+
+    void symmetric::mul_right (const matrix& M, matrix& result) const {
+        if (M.m_width != m_size)
+            throw std::length_error ("Matrixs are not isomeric ");
+        if (result.m_width != m_size || result.m_height != M.m_height)
+            throw std::length_error ("Matrix's sizes are different ");
+        result.touch();
+        for (long unsigned int r = 0; r < M.m_height; r++) {
+            const double* in = M.m_data + r * m_size;
+            double* out = result.m_data + r * m_size;
+            for (long unsigned int j = 0; j < m_size; j++)
+                out[j] = 0.;
+            for (long unsigned int i = 0; i < m_size; i++) {
+                const double* row = m_data + offset (i, 0);
+                double sum = 0.;
+                for (long unsigned int k = 0; k < i; k++) {
+                    sum += in[k] * row[k];
+                    out[k] += in[i] * row[k];
+                }
+                out[i] += sum + in[i] * row[i];
+            }
+        }
+    }
+
+    matrix symmetric::add_to (const matrix& M) const {
+        matrix result (M);
+        add_to (result, 1.);
+        return result;
+    }
+
+    void symmetric::add_to (matrix& M, double alpha) const {
+        if (M.m_width != m_size || M.m_height != m_size)
+            throw std::length_error ("Matrix's sizes are different ");
+        M.touch();
+        for (long unsigned int i = 0; i < m_size; i++)
+            for (long unsigned int j = 0; j <= i; j++) {
+                M.m_data[i * m_size + j] += alpha * m_data[offset (i, j)];
+                if (i != j)
+                    M.m_data[j * m_size + i] += alpha * m_data[offset (i, j)];
+            }
+    }
+
+    symmetric& symmetric::operator+= (const symmetric& B) {
+        add (B);
+        return *this;
+    }
+
+    symmetric& symmetric::operator-= (const symmetric& B) {
+        add (B * -1.);
+        return *this;
+    }
+
+    symmetric& symmetric::operator*= (double B) {
+        scale (B);
+        return *this;
+    }
+
+
+    // ленточная матрица
+    banded::banded (long unsigned int size, long unsigned int lower, long unsigned int upper, double def)
+    : _storage (size, size * (lower + upper + 1), 0.), m_lower (lower), m_upper (upper) {
+        if (lower >= size || upper >= size)
+            throw std::invalid_argument ("Invalid band width ");
+        for (long unsigned int i = 0; i < m_size; i++)
+            for (long unsigned int j = first (i); j < last (i); j++)
+                m_data[offset (i, j)] = def;
+    }
+
+    banded::banded (const matrix& refer, long unsigned int lower, long unsigned int upper)
+    : banded (refer.m_width, lower, upper) {
+        if (refer.m_width != refer.m_height)
+            throw std::length_error ("Matrix is not square ");
+        for (long unsigned int i = 0; i < m_size; i++)
+            for (long unsigned int j = first (i); j < last (i); j++)
+                m_data[offset (i, j)] = refer.m_data[i * m_size + j];
+    }
+
+    long unsigned int banded::offset (long unsigned int row, long unsigned int col) const {
+        return row * (m_lower + m_upper + 1) + (col + m_lower - row);
+    }
+
+    long unsigned int banded::first (long unsigned int row) const {
+        return (row > m_lower)? row - m_lower: 0;
+    }
+
+    long unsigned int banded::last (long unsigned int row) const {
+        return (row + m_upper + 1 < m_size)? row + m_upper + 1: m_size;
+    }
+
+    long unsigned int banded::get_lower() const {
+        return m_lower;
+    }
+
+    long unsigned int banded::get_upper() const {
+        return m_upper;
+    }
+
+    bool banded::in_band (long unsigned int row, long unsigned int col) const {
+        return row < m_size && col >= first (row) && col < last (row);
+    }
+
+    matrix banded::get_matrix() const {
+        matrix result (m_size, 0.);
+        for (long unsigned int i = 0; i < m_size; i++)
+            for (long unsigned int j = first (i); j < last (i); j++)
+                result.m_data[i * m_size + j] = m_data[offset (i, j)];
+        return result;
+    }
+
+    banded banded::get_transpose() const {
+        return banded (*this).to_transpose();
+    }
+
+    banded& banded::to_transpose() {
+        banded result (m_size, m_upper, m_lower);
+        for (long unsigned int i = 0; i < m_size; i++)
+            for (long unsigned int j = first (i); j < last (i); j++)
+                result.m_data[result.offset (j, i)] = m_data[offset (i, j)];
+        *this = std::move (result);
+        return *this;
+    }
+
+    double banded::operator() (long unsigned int row, long unsigned int col) const {
+        if (row >= m_size || col >= m_size)
+            throw std::out_of_range ("Index is out of range ");
+        return in_band (row, col)? m_data[offset (row, col)]: 0.;
+    }
+
+    double& banded::at (long unsigned int row, long unsigned int col) {
+        if (!in_band (row, col))
+            throw std::out_of_range ("Index is out of range ");
+        return m_data[offset (row, col)];
+    }
+
+    matrix banded::mul_left (const matrix& M) const {
+        matrix result (M.m_width, M.m_height);
+        mul_left (M, result);
+        return result;
+    }
+
+    void banded::mul_left (const matrix& M, matrix& result) const {
+        if (M.m_height != m_size)
+            throw std::length_error ("Matrixs are not isomeric ");
+        if (result.m_height != m_size || result.m_width != M.m_width)
+            throw std::length_error ("Matrix's sizes are different ");
+        result.touch();
+        long unsigned int width = M.m_width;
+        for (long unsigned int i = 0; i < m_size; i++) {
+            double* out = result.m_data + i * width;
+            for (long unsigned int j = 0; j < width; j++)
+                out[j] = 0.;
+            for (long unsigned int k = first (i); k < last (i); k++) {
+                double b = m_data[offset (i, k)];
+                const double* in = M.m_data + k * width;
+                for (long unsigned int j = 0; j < width; j++)
+                    out[j] += b * in[j];
+            }
+        }
+    }
+
+    matrix banded::mul_right (const matrix& M) const {
+        matrix result (M.m_width, M.m_height);
+        mul_right (M, result);
+        return result;
+    }
+
+    void banded::mul_right (const matrix& M, matrix& result) const {
+        if (M.m_width != m_size)
+            throw std::length_error ("Matrixs are not isomeric ");
+        if (result.m_width != m_size || result.m_height != M.m_height)
+            throw std::length_error ("Matrix's sizes are different ");
+        result.touch();
+        for (long unsigned int r = 0; r < M.m_height; r++) {
+            double* out = result.m_data + r * m_size;
+            for (long unsigned int j = 0; j < m_size; j++)
+                out[j] = 0.;
+            for (long unsigned int k = 0; k < m_size; k++) {
+                double m = M.m_data[r * m_size + k];
+                for (long unsigned int j = first (k); j < last (k); j++)
+                    out[j] += m * m_data[offset (k, j)];
+            }
+        }
+    }
+
+    matrix banded::add_to (const matrix& M) const {
+        matrix result (M);
+        add_to (result, 1.);
+        return result;
+    }
+
+    void banded::add_to (matrix& M, double alpha) const {
+        if (M.m_width != m_size || M.m_height != m_size)
+            throw std::length_error ("Matrix's sizes are different ");
+        M.touch();
+        for (long unsigned int i = 0; i < m_size; i++)
+            for (long unsigned int j = first (i); j < last (i); j++)
+                M.m_data[i * m_size + j] += alpha * m_data[offset (i, j)];
+    }
+
+    vector banded::solve (const vector& b) const {
+        if (b.m_width * b.m_height != m_size)
+            throw std::length_error ("Matrixs are not isomeric ");
+        vector x (b);
+        solve (x.m_data, 1UL);
+        return x;
+    }
+
+    matrix banded::solve (const matrix& B) const {
+        if (B.m_height != m_size)
+            throw std::length_error ("Matrixs are not isomeric ");
+        matrix X (B);
+        solve (X.m_data, B.m_width);
+        return X;
+    }
+
+    /* исключение Гаусса с выбором ведущего по столбцу, как gbtrf: перестановки
+       сдвигают заполнение вверх не дальше lower, поэтому верхняя лента
+       расширяется до upper + lower */
+    void banded::solve (double* X, long unsigned int width) const {
+        banded LU (m_size, m_lower, std::min (m_upper + m_lower, m_size - 1));
+        for (long unsigned int i = 0; i < m_size; i++)
+            for (long unsigned int j = first (i); j < last (i); j++)
+                LU.m_data[LU.offset (i, j)] = m_data[offset (i, j)];
+        for (long unsigned int k = 0; k < m_size; k++) {
+            long unsigned int pivot = k;
+            for (long unsigned int i = k + 1; i < m_size && i <= k + m_lower; i++)
+                if (std::fabs (LU.m_data[LU.offset (i, k)]) > std::fabs (LU.m_data[LU.offset (pivot, k)]))
+                    pivot = i;
+            if (LU.m_data[LU.offset (pivot, k)] == 0.)
+                throw singular_error();
+            if (pivot != k) {
+                for (long unsigned int j = k; j < LU.last (k); j++)
+                    std::swap (LU.m_data[LU.offset (k, j)], LU.m_data[LU.offset (pivot, j)]);
+                for (long unsigned int j = 0; j < width; j++)
+                    std::swap (X[k * width + j], X[pivot * width + j]);
+            }
+            double diagonal = LU.m_data[LU.offset (k, k)];
+            for (long unsigned int i = k + 1; i < m_size && i <= k + m_lower; i++) {
+                double l = LU.m_data[LU.offset (i, k)] / diagonal;
+                for (long unsigned int j = k + 1; j < LU.last (k); j++)
+                    LU.m_data[LU.offset (i, j)] -= l * LU.m_data[LU.offset (k, j)];
+                for (long unsigned int j = 0; j < width; j++)
+                    X[i * width + j] -= l * X[k * width + j];
+            }
+        }
+        for (long unsigned int step = 0; step < m_size; step++) {
+            long unsigned int i = m_size - 1 - step;
+            double* out = X + i * width;
+            for (long unsigned int k = i + 1; k < LU.last (i); k++) {
+                double u = LU.m_data[LU.offset (i, k)];
+                const double* in = X + k * width;
+                for (long unsigned int j = 0; j < width; j++)
+                    out[j] -= u * in[j];
+            }
+            double pivot = LU.m_data[LU.offset (i, i)];
+            for (long unsigned int j = 0; j < width; j++)
+                out[j] /= pivot;
+        }
+    }
+
+    banded& banded::operator+= (const banded& B) {
+        if (m_size != B.m_size)
+            throw std::length_error ("Matrix's sizes are different ");
+        if (m_lower == B.m_lower && m_upper == B.m_upper) {
+            add (B);
+            return *this;
+        }
+        banded result (m_size, std::max (m_lower, B.m_lower), std::max (m_upper, B.m_upper));
+        for (long unsigned int i = 0; i < m_size; i++) {
+            for (long unsigned int j = first (i); j < last (i); j++)
+                result.m_data[result.offset (i, j)] += m_data[offset (i, j)];
+            for (long unsigned int j = B.first (i); j < B.last (i); j++)
+                result.m_data[result.offset (i, j)] += B.m_data[B.offset (i, j)];
+        }
+        *this = std::move (result);
+        return *this;
+    }
+
+    banded& banded::operator-= (const banded& B) {
+        return *this += B * -1.;
+    }
+
+    /* ширины лент складываются */
+    banded& banded::operator*= (const banded& B) {
+        if (m_size != B.m_size)
+            throw std::length_error ("Matrixs are not isomeric ");
+        banded result (m_size, std::min (m_lower + B.m_lower, m_size - 1), std::min (m_upper + B.m_upper, m_size - 1));
+        for (long unsigned int i = 0; i < m_size; i++)
+            for (long unsigned int k = first (i); k < last (i); k++) {
+                double a = m_data[offset (i, k)];
+                for (long unsigned int j = B.first (k); j < B.last (k); j++)
+                    result.m_data[result.offset (i, j)] += a * B.m_data[B.offset (k, j)];
+            }
+        *this = std::move (result);
+        return *this;
+    }
+
+    banded& banded::operator*= (double B) {
+        scale (B);
+        return *this;
+    }
+
+
+    // внешние функции
+    diagonal operator+ (const diagonal& A, const diagonal& B) {
+        return diagonal (A) += B;
+    }
+
+    diagonal operator- (const diagonal& A, const diagonal& B) {
+        return diagonal (A) -= B;
+    }
+
+    diagonal operator* (const diagonal& A, const diagonal& B) {
+        return diagonal (A) *= B;
+    }
+
+    diagonal operator* (const diagonal& A, double B) {
+        return diagonal (A) *= B;
+    }
+
+    diagonal operator* (double A, const diagonal& B) {
+        return diagonal (B) *= A;
+    }
+
+    matrix operator+ (const diagonal& A, const matrix& B) {
+        return A.add_to (B);
+    }
+
+    matrix operator+ (const matrix& A, const diagonal& B) {
+        return B.add_to (A);
+    }
+
+    matrix operator- (const diagonal& A, const matrix& B) {
+        matrix result (B);
+        result *= -1.;
+        A.add_to (result, 1.);
+        return result;
+    }
+
+    matrix operator- (const matrix& A, const diagonal& B) {
+        matrix result (A);
+        B.add_to (result, -1.);
+        return result;
+    }
+
+    matrix& operator+= (matrix& A, const diagonal& B) {
+        B.add_to (A, 1.);
+        return A;
+    }
+
+    matrix& operator-= (matrix& A, const diagonal& B) {
+        B.add_to (A, -1.);
+        return A;
+    }
+
+    matrix operator* (const diagonal& A, const matrix& B) {
+        return A.mul_left (B);
+    }
+
+    matrix operator* (const matrix& A, const diagonal& B) {
+        return B.mul_right (A);
+    }
+
+    vector operator* (const diagonal& A, const vector& B) {
+        vector result = shaped (B.get_width(), B.get_height());
+        A.mul_left (B, result);
+        return result;
+    }
+
+    vector operator* (const vector& A, const diagonal& B) {
+        vector result = shaped (A.get_width(), A.get_height());
+        B.mul_right (A, result);
+        return result;
+    }
+
+    triangular operator+ (const triangular& A, const triangular& B) {
+        return triangular (A) += B;
+    }
+
+    triangular operator- (const triangular& A, const triangular& B) {
+        return triangular (A) -= B;
+    }
+
+    triangular operator* (const triangular& A, const triangular& B) {
+        return triangular (A) *= B;
+    }
+
+    triangular operator* (const triangular& A, double B) {
+        return triangular (A) *= B;
+    }
+
+    triangular operator* (double A, const triangular& B) {
+        return triangular (B) *= A;
+    }
+
+    matrix operator+ (const triangular& A, const matrix& B) {
+        return A.add_to (B);
+    }
+
+    matrix operator+ (const matrix& A, const triangular& B) {
+        return B.add_to (A);
+    }
+
+    matrix operator- (const triangular& A, const matrix& B) {
+        matrix result (B);
+        result *= -1.;
+        A.add_to (result, 1.);
+        return result;
+    }
+
+    matrix operator- (const matrix& A, const triangular& B) {
+        matrix result (A);
+        B.add_to (result, -1.);
+        return result;
+    }
+
+    matrix& operator+= (matrix& A, const triangular& B) {
+        B.add_to (A, 1.);
+        return A;
+    }
+
+    matrix& operator-= (matrix& A, const triangular& B) {
+        B.add_to (A, -1.);
+        return A;
+    }
+
+    matrix operator* (const triangular& A, const matrix& B) {
+        return A.mul_left (B);
+    }
+
+    matrix operator* (const matrix& A, const triangular& B) {
+        return B.mul_right (A);
+    }
+
+    vector operator* (const triangular& A, const vector& B) {
+        vector result = shaped (B.get_width(), B.get_height());
+        A.mul_left (B, result);
+        return result;
+    }
+
+    vector operator* (const vector& A, const triangular& B) {
+        vector result = shaped (A.get_width(), A.get_height());
+        B.mul_right (A, result);
+        return result;
+    }
+
+    symmetric operator+ (const symmetric& A, const symmetric& B) {
+        return symmetric (A) += B;
+    }
+
+    symmetric operator- (const symmetric& A, const symmetric& B) {
+        return symmetric (A) -= B;
+    }
+
+    symmetric operator* (const symmetric& A, double B) {
+        return symmetric (A) *= B;
+    }
+
+    symmetric operator* (double A, const symmetric& B) {
+        return symmetric (B) *= A;
+    }
+
+    matrix operator+ (const symmetric& A, const matrix& B) {
+        return A.add_to (B);
+    }
+
+    matrix operator+ (const matrix& A, const symmetric& B) {
+        return B.add_to (A);
+    }
+
+    matrix operator- (const symmetric& A, const matrix& B) {
+        matrix result (B);
+        result *= -1.;
+        A.add_to (result, 1.);
+        return result;
+    }
+
+    matrix operator- (const matrix& A, const symmetric& B) {
+        matrix result (A);
+        B.add_to (result, -1.);
+        return result;
+    }
+
+    matrix& operator+= (matrix& A, const symmetric& B) {
+        B.add_to (A, 1.);
+        return A;
+    }
+
+    matrix& operator-= (matrix& A, const symmetric& B) {
+        B.add_to (A, -1.);
+        return A;
+    }
+
+    matrix operator* (const symmetric& A, const matrix& B) {
+        return A.mul_left (B);
+    }
+
+    matrix operator* (const matrix& A, const symmetric& B) {
+        return B.mul_right (A);
+    }
+
+    vector operator* (const symmetric& A, const vector& B) {
+        vector result = shaped (B.get_width(), B.get_height());
+        A.mul_left (B, result);
+        return result;
+    }
+
+    vector operator* (const vector& A, const symmetric& B) {
+        vector result = shaped (A.get_width(), A.get_height());
+        B.mul_right (A, result);
+        return result;
+    }
+
+    banded operator+ (const banded& A, const banded& B) {
+        return banded (A) += B;
+    }
+
+    banded operator- (const banded& A, const banded& B) {
+        return banded (A) -= B;
+    }
+
+    banded operator* (const banded& A, const banded& B) {
+        return banded (A) *= B;
+    }
+
+    banded operator* (const banded& A, double B) {
+        return banded (A) *= B;
+    }
+
+    banded operator* (double A, const banded& B) {
+        return banded (B) *= A;
+    }
+
+    matrix operator+ (const banded& A, const matrix& B) {
+        return A.add_to (B);
+    }
+
+    matrix operator+ (const matrix& A, const banded& B) {
+        return B.add_to (A);
+    }
+
+    matrix operator- (const banded& A, const matrix& B) {
+        matrix result (B);
+        result *= -1.;
+        A.add_to (result, 1.);
+        return result;
+    }
+
+    matrix operator- (const matrix& A, const banded& B) {
+        matrix result (A);
+        B.add_to (result, -1.);
+        return result;
+    }
+
+    matrix& operator+= (matrix& A, const banded& B) {
+        B.add_to (A, 1.);
+        return A;
+    }
+
+    matrix& operator-= (matrix& A, const banded& B) {
+        B.add_to (A, -1.);
+        return A;
+    }
+
+    matrix operator* (const banded& A, const matrix& B) {
+        return A.mul_left (B);
+    }
+
+    matrix operator* (const matrix& A, const banded& B) {
+        return B.mul_right (A);
+    }
+
+    vector operator* (const banded& A, const vector& B) {
+        vector result = shaped (B.get_width(), B.get_height());
+        A.mul_left (B, result);
+        return result;
+    }
+
+    vector operator* (const vector& A, const banded& B) {
+        vector result = shaped (A.get_width(), A.get_height());
+        B.mul_right (A, result);
+        return result;
+    }
+
+
+    // стейтмент вывода
+    std::ostream& operator<< (std::ostream& out, const diagonal& D) {
+        return out << D.get_matrix();
+    }
+
+    std::ostream& operator<< (std::ostream& out, const triangular& T) {
+        return out << T.get_matrix();
+    }
+
+    std::ostream& operator<< (std::ostream& out, const symmetric& S) {
+        return out << S.get_matrix();
+    }
+
+    std::ostream& operator<< (std::ostream& out, const banded& B) {
+        return out << B.get_matrix();
+    }
+}
+
+
+#endif /* STRUCTURED_CPP */
@@ -0,0 +1,257 @@
+#ifndef STRUCTURED_HPP
+#define STRUCTURED_HPP
+
+
+#include "matrix.hpp"
+#include "vector.hpp"
+#include <iostream>
+
+
+namespace linear {
+    // общее хранилище структурированных матриц { size * size }
+    class _storage {
+        protected:
+            double* m_data;
+            long unsigned int m_size;   // порядок матрицы
+            long unsigned int m_length; // число хранимых элементов
+
+            _storage (long unsigned int size, long unsigned int length, double def);
+            _storage (const _storage&);
+            _storage (_storage&&);
+            ~_storage();
+
+            _storage& operator= (const _storage&);
+            _storage& operator= (_storage&&);
+
+            // поэлементные операции над хранимыми элементами
+            void scale (double);
+            void add (const _storage&);
+
+        public:
+            long unsigned int get_size() const;
+    };
+
+
+    /* диагональная матрица: n элементов */
+    class diagonal: public _storage {
+        public:
+            explicit diagonal (long unsigned int size = 1, double def = 0.);
+            explicit diagonal (const matrix&); // диагональ плотной матрицы
+            explicit diagonal (const vector&);
+            diagonal (const std::initializer_list<double> &list);
+
+            // вспомогательные
+            matrix get_matrix() const;
+            diagonal get_transpose() const;
+            diagonal& to_transpose();
+            double operator() (long unsigned int row, long unsigned int col) const;
+
+            // индексирование диагонали
+            double& operator[] (long unsigned int index);
+            double operator[] (long unsigned int index) const;
+
+            // ядра
+            matrix mul_left (const matrix&) const;  // D * M
+            void mul_left (const matrix&, matrix& result) const;
+            matrix mul_right (const matrix&) const; // M * D
+            void mul_right (const matrix&, matrix& result) const;
+            matrix add_to (const matrix&) const;    // M + D
+            void add_to (matrix&, double alpha) const; // M += alpha D на месте
+            vector solve (const vector&) const;     // D x = b
+            matrix solve (const matrix&) const;     // D X = B
+
+            // присваивание
+            diagonal& operator+= (const diagonal&);
+            diagonal& operator-= (const diagonal&);
+            diagonal& operator*= (const diagonal&);
+            diagonal& operator*= (double);
+    };
+
+
+    /* треугольная матрица: n (n + 1) / 2 элементов построчно */
+    class triangular: public _storage {
+        private:
+            bool m_upper;
+
+            long unsigned int offset (long unsigned int row, long unsigned int col) const;
+            long unsigned int first (long unsigned int row) const; // первый хранимый столбец строки
+            long unsigned int last (long unsigned int row) const;  // за последним хранимым столбцом
+            void solve (double* X, long unsigned int width) const; // на месте, X { width * size }
+
+        public:
+            explicit triangular (long unsigned int size = 1, bool upper = true, double def = 0.);
+            explicit triangular (const matrix&, bool upper = true); // треугольник плотной матрицы
+
+            // вспомогательные
+            bool is_upper() const;
+            matrix get_matrix() const;
+            triangular get_transpose() const;
+            triangular& to_transpose();
+            double operator() (long unsigned int row, long unsigned int col) const;
+            double& at (long unsigned int row, long unsigned int col);
+
+            // ядра
+            matrix mul_left (const matrix&) const;  // T * M
+            void mul_left (const matrix&, matrix& result) const;
+            matrix mul_right (const matrix&) const; // M * T
+            void mul_right (const matrix&, matrix& result) const;
+            matrix add_to (const matrix&) const;    // M + T
+            void add_to (matrix&, double alpha) const; // M += alpha T на месте
+            vector solve (const vector&) const;     // T x = b, прямая или обратная подстановка
+            matrix solve (const matrix&) const;     // T X = B
+
+            // присваивание
+            triangular& operator+= (const triangular&);
+            triangular& operator-= (const triangular&);
+            triangular& operator*= (const triangular&);
+            triangular& operator*= (double);
+    };
+
+
+    /* симметричная матрица: нижний треугольник построчно */
+    class symmetric: public _storage {
+        private:
+            long unsigned int offset (long unsigned int row, long unsigned int col) const;
+
+        public:
+            explicit symmetric (long unsigned int size = 1, double def = 0.);
+            explicit symmetric (const matrix&); // нижний треугольник плотной матрицы
+
+            // вспомогательные
+            matrix get_matrix() const;
+            symmetric get_transpose() const;
+            symmetric& to_transpose();
+            double operator() (long unsigned int row, long unsigned int col) const;
+            double& at (long unsigned int row, long unsigned int col);
+
+            // ядра
+            matrix mul_left (const matrix&) const;  // S * M
+            void mul_left (const matrix&, matrix& result) const;
+            matrix mul_right (const matrix&) const; // M * S
+            void mul_right (const matrix&, matrix& result) const;
+            matrix add_to (const matrix&) const;    // M + S
+            void add_to (matrix&, double alpha) const; // M += alpha S на месте
+
+            // присваивание
+            symmetric& operator+= (const symmetric&);
+            symmetric& operator-= (const symmetric&);
+            symmetric& operator*= (double);
+    };
+
+
+    /* ленточная матрица: kl поддиагоналей, ku наддиагоналей, (kl + ku + 1) n элементов */
+    class banded: public _storage {
+        private:
+            long unsigned int m_lower;
+            long unsigned int m_upper;
+
+            long unsigned int offset (long unsigned int row, long unsigned int col) const;
+            long unsigned int first (long unsigned int row) const;
+            long unsigned int last (long unsigned int row) const;
+            void solve (double* X, long unsigned int width) const;
+
+        public:
+            explicit banded (long unsigned int size = 1, long unsigned int lower = 0, long unsigned int upper = 0, double def = 0.);
+            explicit banded (const matrix&, long unsigned int lower, long unsigned int upper); // лента плотной матрицы
+
+            // вспомогательные
+            long unsigned int get_lower() const;
+            long unsigned int get_upper() const;
+            bool in_band (long unsigned int row, long unsigned int col) const;
+            matrix get_matrix() const;
+            banded get_transpose() const;
+            banded& to_transpose();
+            double operator() (long unsigned int row, long unsigned int col) const;
+            double& at (long unsigned int row, long unsigned int col);
+
+            // ядра
+            matrix mul_left (const matrix&) const;  // B * M
+            void mul_left (const matrix&, matrix& result) const;
+            matrix mul_right (const matrix&) const; // M * B
+            void mul_right (const matrix&, matrix& result) const;
+            matrix add_to (const matrix&) const;    // M + B
+            void add_to (matrix&, double alpha) const; // M += alpha B на месте
+            vector solve (const vector&) const;     // LU в ленте с выбором ведущего по столбцу
+            matrix solve (const matrix&) const;
+
+            // присваивание
+            banded& operator+= (const banded&);
+            banded& operator-= (const banded&);
+            banded& operator*= (const banded&);
+            banded& operator*= (double);
+    };
+
+
+    // внешние функции
+    diagonal operator+ (const diagonal&, const diagonal&);
+    diagonal operator- (const diagonal&, const diagonal&);
+    diagonal operator* (const diagonal&, const diagonal&);
+    diagonal operator* (const diagonal&, double);
+    diagonal operator* (double, const diagonal&);
+    matrix operator+ (const diagonal&, const matrix&);
+    matrix operator+ (const matrix&, const diagonal&);
+    matrix operator- (const diagonal&, const matrix&);
+    matrix operator- (const matrix&, const diagonal&);
+    matrix& operator+= (matrix&, const diagonal&);
+    matrix& operator-= (matrix&, const diagonal&);
+    matrix operator* (const diagonal&, const matrix&);
+    matrix operator* (const matrix&, const diagonal&);
+    vector operator* (const diagonal&, const vector&);
+    vector operator* (const vector&, const diagonal&);
+
+    triangular operator+ (const triangular&, const triangular&);
+    triangular operator- (const triangular&, const triangular&);
+    triangular operator* (const triangular&, const triangular&);
+    triangular operator* (const triangular&, double);
+    triangular operator* (double, const triangular&);
+    matrix operator+ (const triangular&, const matrix&);
+    matrix operator+ (const matrix&, const triangular&);
+    matrix operator- (const triangular&, const matrix&);
+    matrix operator- (const matrix&, const triangular&);
+    matrix& operator+= (matrix&, const triangular&);
+    matrix& operator-= (matrix&, const triangular&);
+    matrix operator* (const triangular&, const matrix&);
+    matrix operator* (const matrix&, const triangular&);
+    vector operator* (const triangular&, const vector&);
+    vector operator* (const vector&, const triangular&);
+
+    symmetric operator+ (const symmetric&, const symmetric&);
+    symmetric operator- (const symmetric&, const symmetric&);
+    symmetric operator* (const symmetric&, double);
+    symmetric operator* (double, const symmetric&);
+    matrix operator+ (const symmetric&, const matrix&);
+    matrix operator+ (const matrix&, const symmetric&);
+    matrix operator- (const symmetric&, const matrix&);
+    matrix operator- (const matrix&, const symmetric&);
+    matrix& operator+= (matrix&, const symmetric&);
+    matrix& operator-= (matrix&, const symmetric&);
+    matrix operator* (const symmetric&, const matrix&);
+    matrix operator* (const matrix&, const symmetric&);
+    vector operator* (const symmetric&, const vector&);
+    vector operator* (const vector&, const symmetric&);
+
+    banded operator+ (const banded&, const banded&);
+    banded operator- (const banded&, const banded&);
+    banded operator* (const banded&, const banded&);
+    banded operator* (const banded&, double);
+    banded operator* (double, const banded&);
+    matrix operator+ (const banded&, const matrix&);
+    matrix operator+ (const matrix&, const banded&);
+    matrix operator- (const banded&, const matrix&);
+    matrix operator- (const matrix&, const banded&);
+    matrix& operator+= (matrix&, const banded&);
+    matrix& operator-= (matrix&, const banded&);
+    matrix operator* (const banded&, const matrix&);
+    matrix operator* (const matrix&, const banded&);
+    vector operator* (const banded&, const vector&);
+    vector operator* (const vector&, const banded&);
+
+    // стейтмент вывода
+    std::ostream& operator<< (std::ostream&, const diagonal&);
+    std::ostream& operator<< (std::ostream&, const triangular&);
+    std::ostream& operator<< (std::ostream&, const symmetric&);
+    std::ostream& operator<< (std::ostream&, const banded&);
+}
+
+
+#endif /* STRUCTURED_HPP */
@@ -3,6 +3,8 @@
 
 
 #include "vector.hpp"
+#include "parallel.hpp"
+#include "reduce.hpp"
 #include <stdexcept>
 #include <iomanip>
 #include <cmath>
@@ -48,8 +50,10 @@ namespace linear {
                   << NCOL << std::endl;
 #endif /* DEBUG */
 
-        for (unsigned long int i = 0; i < m_width; i++) 
-            m_data[i] = def;
+        parallel::for_range (m_width, 1UL, [this, def] (unsigned long int begin, unsigned long int end) {
+            for (unsigned long int i = begin; i < end; i++) 
+                m_data[i] = def;
+        });
     }
 
     vector::vector (const _row& refer) 
@@ -67,7 +71,7 @@ namespace linear {
     }
 
     vector::vector (const vector& refer)
-    : matrix (refer.m_width, 1UL) {
+    : matrix (refer.m_width, refer.m_height) {
 
 #ifdef DEBUG
         std::cerr << "\033[1A\033[2K" 
@@ -76,7 +80,7 @@ namespace linear {
                   << refer.id << NCOL << std::endl;
 #endif /* DEBUG */
 
-        for (unsigned long int i = 0; i < m_width; i++)
+        for (unsigned long int i = 0; i < m_width * m_height; i++)
             m_data[i] = refer.m_data[i];
     }
 
@@ -110,10 +114,7 @@ namespace linear {
 
     // вспомогательные
     double vector::abs() const {
-        double abs = 0;
-        for (unsigned long int i = 0; i < m_width; i++)
-            abs += m_data[i] * m_data[i];
-        return sqrt(abs);
+        return norm();
     }
 
     vector vector::get_transpose() const {
@@ -133,6 +134,7 @@ namespace linear {
 
     vector& vector::to_normalize() {
         double len = abs();
+        touch();
         for (unsigned long int i = 0; i < m_width; i++) 
             m_data[i] = m_data[i] / len;
         return *this;
@@ -155,6 +157,7 @@ namespace linear {
             throw std::invalid_argument ("Invalid index ");
         if (index >= m_width) 
             throw std::out_of_range ("Index is out of range ");
+        touch(); // запись через ссылку не отследить
         return m_data[index];
     }
 
@@ -182,7 +185,7 @@ namespace linear {
     }
 
     vector& vector::operator= (vector&& refer) {
-        matrix::operator=(refer);
+        matrix::operator=(std::move (refer));
         return *this;
     }
 
@@ -252,6 +255,17 @@ namespace linear {
         return vector (A) *= B;
     }
 
+    vector hadamard (const vector& A, const vector& B) {
+        if (A.m_width != B.m_width || A.m_height != B.m_height)
+            throw std::length_error ("Matrix's sizes are different ");
+        vector C (A.m_width * A.m_height);
+        C.m_width = A.m_width;
+        C.m_height = A.m_height;
+        for (unsigned long int i = 0; i < A.m_width * A.m_height; i++)
+            C.m_data[i] = A.m_data[i] * B.m_data[i];
+        return C;
+    }
+
     /* векторное произведение */
     vector vect_mul (const vector& A, const vector& B) {
         if (A.m_width != 3 || B.m_width != 3) 
@@ -266,10 +280,7 @@ namespace linear {
     double scal_mul (const vector& A, const vector& B) {
         if (A.m_width != B.m_width)
             throw std::invalid_argument ("Invalid vectors ");
-        double result = 0.;
-        for (unsigned long int i = 0; i < A.m_width; i++) 
-            result += A.m_data[i] * B.m_data[i];
-        return result;
+        return reduction::dot (A.m_data, B.m_data, A.m_width);
     }
 
 
@@ -293,12 +304,22 @@ namespace linear {
         return scal_mul (A, B) / (A.abs() * B.abs());
     }
 
+    /* модуль векторного произведения без построения вектора; проверка как в vect_mul */
+    static double vect_abs (const vector& A, const vector& B) {
+        if (A.get_width() != 3 || B.get_width() != 3)
+            throw std::invalid_argument ("Invalid vectors ");
+        double x = A[1] * B[2] - A[2] * B[1];
+        double y = A[2] * B[0] - A[0] * B[2];
+        double z = A[0] * B[1] - A[1] * B[0];
+        return sqrt (x * x + y * y + z * z);
+    }
+
     double sin (const vector& A, const vector& B) {
-        return vect_mul (A, B).abs() / (A.abs() * B.abs());
+        return vect_abs (A, B) / (A.abs() * B.abs());
     }
 
     double angle (const vector& A, const vector& B) {
-        return (atan2 (vect_mul (A, B).abs(), scal_mul (A, B)) * 180 / M_PI);
+        return (atan2 (vect_abs (A, B), scal_mul (A, B)) * 180 / M_PI);
     }
 }
  
@@ -19,6 +19,7 @@ namespace linear {
         friend vector operator* (const vector&, const matrix&);
         friend vector vect_mul (const vector&, const vector&); // векторное произведение
         friend double scal_mul (const vector&, const vector&); // скалярное произведение
+        friend vector hadamard (const vector&, const vector&); // поэлементное произведение
 
         // стейтмент вывода
         friend std::ostream& operator<< (std::ostream&, const vector&);